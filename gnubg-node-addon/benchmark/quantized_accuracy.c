@@ -0,0 +1,154 @@
+/*
+ * Accuracy of the quantised (int16) nets against the float nets.
+ *
+ * Plays self-play games at 0-ply from the opening with seeded dice to get
+ * a corpus of positions, then ranks every legal move of each position
+ * with the float nets and again with gnubg_set_quantized(1).  Reports how
+ * far the equities move and how often the best move changes.
+ *
+ * Build after `npm run build:native`, from the addon directory:
+ *
+ *   gcc -O2 -DHAVE_CONFIG_H -Iinclude -Ivendor/core -Ivendor/core/lib \
+ *       $(pkg-config --cflags glib-2.0) benchmark/quantized_accuracy.c \
+ *       $(find build/Release/obj.target/gnubg_hints/lib build/Release/obj.target/gnubg_hints/vendor -name '*.o') \
+ *       $(pkg-config --libs glib-2.0 gthread-2.0) -lm -o quantized_accuracy
+ *   ./quantized_accuracy [positions] [seed]
+ */
+
+#include "gnubg_core.h"
+#include "eval.h"
+#include "positionid.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MAX_HINTS 64
+
+typedef struct {
+    TanBoard board;
+    int dice[2];
+} corpus_position;
+
+static unsigned int seed;
+
+static int roll(void) {
+    seed = seed * 1103515245u + 12345u;
+    return (int)((seed >> 16) % 6) + 1;
+}
+
+static void opening(TanBoard board) {
+    memset(board, 0, sizeof(TanBoard));
+    for (int side = 0; side < 2; side++) {
+        board[side][5] = 5;
+        board[side][7] = 3;
+        board[side][12] = 5;
+        board[side][23] = 2;
+    }
+}
+
+static int game_over(TanBoard board) {
+    for (int side = 0; side < 2; side++) {
+        int checkers = 0;
+        for (int i = 0; i < 25; i++)
+            checkers += board[side][i];
+        if (!checkers)
+            return 1;
+    }
+    return 0;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv) {
+    int const n = argc > 1 ? atoi(argv[1]) : 2000;
+    seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+
+    if (n <= 0 || gnubg_initialize(NULL) != 0 || gnubg_thread_init() != 0) {
+        fprintf(stderr, "Failed to initialize GNU Backgammon core\n");
+        return 1;
+    }
+
+    gnubg_eval_settings settings;
+    gnubg_default_settings(&settings);
+    settings.eval_plies = 0;
+    settings.use_pruning = 0;
+    settings.use_cache = 0;
+
+    corpus_position *corpus = malloc(n * sizeof(*corpus));
+    move (*float_hints)[MAX_HINTS] = malloc(n * sizeof(*float_hints));
+    move hints[MAX_HINTS];
+    int *float_count = malloc(n * sizeof(int));
+    double *deltas = malloc((size_t)n * MAX_HINTS * sizeof(double));
+    TanBoard board;
+
+    /* The corpus, with the float nets choosing the moves */
+    opening(board);
+    for (int p = 0; p < n; p++) {
+        if (game_over(board))
+            opening(board);
+
+        memcpy(corpus[p].board, board, sizeof(TanBoard));
+        corpus[p].dice[0] = roll();
+        corpus[p].dice[1] = roll();
+
+        float_count[p] = gnubg_hint_move_with_settings(board, corpus[p].dice, float_hints[p], MAX_HINTS, NULL,
+                                                       &settings);
+        if (float_count[p] > 0)
+            ApplyMove(board, float_hints[p][0].anMove, 0);
+        SwapSides(board);
+    }
+
+    if (gnubg_set_quantized(1) != 0) {
+        fprintf(stderr, "Failed to quantise the nets\n");
+        return 1;
+    }
+
+    int compared = 0, disagree = 0;
+    size_t c = 0;
+    double sum = 0.0, max = 0.0;
+
+    for (int p = 0; p < n; p++) {
+        int count = gnubg_hint_move_with_settings(corpus[p].board, corpus[p].dice, hints, MAX_HINTS, NULL,
+                                                  &settings);
+
+        if (count <= 1 || float_count[p] <= 1)
+            continue;
+
+        compared++;
+        if (!EqualKeys(hints[0].key, float_hints[p][0].key))
+            disagree++;
+
+        for (int i = 0; i < count; i++)
+            for (int j = 0; j < float_count[p]; j++)
+                if (EqualKeys(hints[i].key, float_hints[p][j].key)) {
+                    double const d = fabs(hints[i].rScore - float_hints[p][j].rScore);
+
+                    deltas[c++] = d;
+                    sum += d;
+                    if (d > max)
+                        max = d;
+                    break;
+                }
+    }
+
+    if (!c) {
+        fprintf(stderr, "No positions to compare\n");
+        return 1;
+    }
+    qsort(deltas, c, sizeof(double), compare_double);
+
+    printf("%d positions with a choice of moves, %zu moves compared\n", compared, c);
+    printf("|equity difference|: mean %.5f  p99 %.5f  max %.5f\n", sum / c, deltas[c * 99 / 100], max);
+    printf("best move differs: %d of %d (%.2f%%)\n", disagree, compared, 100.0 * disagree / compared);
+
+    free(deltas);
+    free(float_count);
+    free(float_hints);
+    free(corpus);
+    gnubg_shutdown();
+    return 0;
+}
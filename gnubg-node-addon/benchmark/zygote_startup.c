@@ -0,0 +1,92 @@
+/*
+ * Worker start-up from a zygote against a cold start.
+ *
+ * Times gnubg_initialize() and a first move hint in a fresh process, then
+ * warms the evaluation cache with a few hints and forks children with
+ * gnubg_fork().  Each child reports how long it took from the fork to its
+ * first hint, with the nets, bearoff databases and cache it inherited.
+ *
+ * Build after `npm run build:native`, from the addon directory:
+ *
+ *   gcc -O2 -DHAVE_CONFIG_H -Iinclude -Ivendor/core -Ivendor/core/lib \
+ *       $(pkg-config --cflags glib-2.0) benchmark/zygote_startup.c \
+ *       $(find build/Release/obj.target/gnubg_hints/lib build/Release/obj.target/gnubg_hints/vendor -name '*.o') \
+ *       $(pkg-config --libs glib-2.0 gthread-2.0) -lm -o zygote_startup
+ *   ./zygote_startup [children] [threads]
+ */
+
+#include "gnubg_core.h"
+#include "eval.h"
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_HINTS 8
+
+static void opening(TanBoard board) {
+    memset(board, 0, sizeof(TanBoard));
+    for (int side = 0; side < 2; side++) {
+        board[side][5] = 5;
+        board[side][7] = 3;
+        board[side][12] = 5;
+        board[side][23] = 2;
+    }
+}
+
+/* The first hint of a worker; every child asks for the same one */
+static int first_hint(void) {
+    TanBoard board;
+    int dice[2] = { 3, 1 };
+    move hints[MAX_HINTS];
+
+    opening(board);
+    return gnubg_hint_move(board, dice, hints, MAX_HINTS);
+}
+
+int main(int argc, char **argv) {
+    int const children = argc > 1 ? atoi(argv[1]) : 4;
+    int const threads = argc > 2 ? atoi(argv[2]) : 2;
+
+    gint64 t = g_get_monotonic_time();
+    if (gnubg_initialize(NULL) != 0 || gnubg_thread_init() != 0) {
+        fprintf(stderr, "Failed to initialize GNU Backgammon core\n");
+        return 1;
+    }
+    gnubg_configure(2, 2, 1, 0.0, threads);
+    gint64 const tInit = g_get_monotonic_time() - t;
+
+    t = g_get_monotonic_time();
+    if (first_hint() <= 0) {
+        fprintf(stderr, "No hints\n");
+        return 1;
+    }
+    printf("cold start: initialize %.1f ms, first hint %.1f ms\n", tInit / 1000.0,
+           (g_get_monotonic_time() - t) / 1000.0);
+
+    for (int i = 0; i < children; i++) {
+        gint64 const tFork = g_get_monotonic_time();
+        int const pid = gnubg_fork();
+
+        if (pid < 0) {
+            fprintf(stderr, "gnubg_fork failed\n");
+            return 1;
+        }
+        if (pid == 0) {
+            /* monotonic time is the same clock in both processes */
+            gint64 const tReady = g_get_monotonic_time();
+            int const ok = first_hint() > 0;
+
+            printf("child %d: ready %.2f ms, first hint %.2f ms after the fork\n", i,
+                   (tReady - tFork) / 1000.0, (g_get_monotonic_time() - tFork) / 1000.0);
+            gnubg_shutdown();
+            _exit(ok ? 0 : 1);
+        }
+        waitpid(pid, NULL, 0);
+    }
+
+    gnubg_shutdown();
+    return 0;
+}
@@ -7,12 +7,12 @@
       "cflags": [
         "-O3",
         "-ffast-math",
-        "-march=native",
         "<!@(pkg-config --cflags glib-2.0 gobject-2.0 gthread-2.0)"
       ],
       "sources": [
         "src/gnubg_addon.cpp",
         "src/hint_wrapper.cpp",
+        "src/thread_pool.cpp",
         "src/board_converter.cpp",
         "src/gnubg_core_wrapper.cpp",
         "lib/gnubg_core.c",
@@ -36,6 +36,7 @@
         "vendor/core/lib/inputs.c",
         "vendor/core/lib/list.c",
         "vendor/core/lib/neuralnet.c",
+        "vendor/core/lib/nnkernels.c",
         "vendor/core/lib/isaac.c",
         "vendor/core/lib/md5.c",
         "vendor/core/lib/SFMT.c",
@@ -67,7 +68,6 @@
             "OTHER_CFLAGS": [
               "-O3",
               "-ffast-math",
-              "-march=native",
               "<!@(pkg-config --cflags glib-2.0 gobject-2.0 gthread-2.0)"
             ]
           }
@@ -76,7 +76,6 @@
           "cflags": [
             "-O3",
             "-ffast-math",
-            "-march=native",
             "-pthread",
             "<!@(pkg-config --cflags glib-2.0 gobject-2.0 gthread-2.0)"
           ],
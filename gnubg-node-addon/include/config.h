@@ -40,7 +40,9 @@
 /* Math functions */
 #define HAVE_LIBM 1
 
-/* SIMD support intentionally disabled for portability */
+/* USE_SIMD_INSTRUCTIONS stays undefined: it bakes one instruction set into
+ * the build.  The neural net kernels in vendor/core/lib/nnkernels.c are instead picked
+ * at load time from the CPU's capabilities. */
 
 /* Threading */
 #define USE_MULTITHREAD 1
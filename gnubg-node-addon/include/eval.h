@@ -73,6 +73,18 @@ typedef enum {
 #define MAX_INCOMPLETE_MOVES 3875
 #define MAX_MOVES 3060
 
+/* The positions of the movelist being generated, so that SaveMoves()
+ * finds a duplicate without scanning the list. A slot holds the
+ * generation it was filled in and an index into the list; slots of older
+ * generations are empty, so starting a new list costs one increment. */
+#define MOVESET_BITS 13         /* over twice MAX_INCOMPLETE_MOVES slots */
+#define MOVESET_INDEX_BITS 12   /* enough for MAX_INCOMPLETE_MOVES */
+
+typedef struct {
+    unsigned int gen;
+    unsigned int aSlot[1 << MOVESET_BITS];
+} moveset;
+
 typedef struct movefilter_s {
     int Accept;                 /* always allow this many moves. 0 means don't use this */
     /* level, since at least 1 is needed when used. */
@@ -295,6 +307,26 @@ typedef struct {
     move *amMoves;
 } movelist;
 
+/* What the move search keeps of each legal move. A move carries a whole
+ * evalsetup the search never reads, so candidates are only turned into
+ * moves for the lists GenerateMoves and FindnSaveBestMoves return. */
+typedef struct {
+    int anMove[8];
+    positionkey key;
+    unsigned int cMoves, cPips;
+    float rScore, rScore2;
+    float arEvalMove[NUM_ROLLOUT_OUTPUTS];
+    int nPlies;                 /* ply arEvalMove was evaluated at */
+} candidate;
+
+typedef struct {
+    unsigned int cMoves;
+    unsigned int cMaxMoves, cMaxPips;
+    int iMoveBest;
+    float rBestScore;
+    candidate *acMoves;
+} candidatelist;
+
 /* cube efficiencies */
 
 extern float rOSCubeX;
@@ -330,6 +362,21 @@ typedef int (*classevalfunc) (const TanBoard anBoard, float arOutput[], const bg
 
 extern classevalfunc acef[N_CLASSES];
 
+/* Largest number of positions handed to the neural nets in one batch */
+#define EVAL_BATCH 32
+
+extern int EvalClassBatch(positionclass pc, unsigned int c, const TanBoard * const apBoard[],
+                          float aarOutput[][NUM_OUTPUTS], const bgvariation bgv);
+
+/* Runs fn(data, i) for every i below c, possibly on several threads, and
+ * returns once all calls are done. When set, threads that asked for it
+ * (ThreadLocalData.fParallelEval) hand it the candidates of a 1+ ply
+ * ScoreMoves, and the 21 rolls of the top ply of a 2+ ply evaluation.
+ * Only the locking evals do this. */
+typedef void (*EvalParallelFor) (unsigned int c, void (*fn) (void *data, unsigned int i), void *data);
+
+extern EvalParallelFor fnEvalParallelFor;
+
 /* Evaluation cache size is 2^SIZE entries */
 #define CACHE_SIZE_DEFAULT 19
 #define CACHE_SIZE_GUIMAX 23
@@ -366,6 +413,12 @@ extern void
 EXP_LOCK_FUN(int, FindBestMove, int anMove[8], int nDice0, int nDice1,
              TanBoard anBoard, const cubeinfo * pci, evalcontext * pec, movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]);
 
+/* Fill the evaluation cache ahead of 0-ply FindBestMove() calls on c
+ * positions, one roll each, running the neural nets on the candidates of
+ * all of them in batches. pci and pec are those of the calls. */
+EXP_LOCK_FUN(void, PrimeBestMoves, unsigned int c, const TanBoard * const apBoard[],
+             const unsigned int aanDice[][2], const cubeinfo * pci, const evalcontext * pec);
+
 EXP_LOCK_FUN(int, FindnSaveBestMoves, movelist * pml,
              int nDice0, int nDice1, const TanBoard anBoard,
              positionkey * keyMove, const float rThr,
@@ -396,6 +449,8 @@ extern int
 
 extern void EvalCacheFlush(void);
 extern int EvalCacheResize(unsigned int cNew);
+extern int EvalCacheOpen(const char *szFile, unsigned int cNew);
+extern int EvalSetQuantized(int f);
 extern int EvalCacheStats(unsigned int *pcUsed, unsigned int *pcLookup, unsigned int *pcHit);
 extern double GetEvalCacheSize(void);
 void SetEvalCacheSize(unsigned int size);
@@ -406,9 +461,20 @@ extern evalCache cEval;
 extern evalCache cpEval;
 extern unsigned int cCache;
 
+/* Memo of the contact input encoding, one per thread */
+typedef struct inputmemo inputmemo;
+extern inputmemo *InputMemoNew(void);
+
 extern int
  GenerateMoves(movelist * pml, const TanBoard anBoard, int n0, int n1, int fPartial);
 
+/* As GenerateMoves, into the calling thread's candidate buffer */
+extern int
+ GenerateCandidates(candidatelist * pcl, const TanBoard anBoard, int n0, int n1, int fPartial);
+
+/* Fill pm from pc; pec is the context pc was scored with, or NULL */
+extern void CandidateToMove(move * pm, const candidate * pc, const evalcontext * pec);
+
 extern int ApplySubMove(TanBoard anBoard, const int iSrc, const int nRoll, const int fCheckLegal);
 
 extern int ApplyMove(TanBoard anBoard, const int anMove[8], const int fCheckLegal);
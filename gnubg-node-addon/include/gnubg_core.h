@@ -10,12 +10,94 @@ extern "C" {
 /* Initialize the engine with optional weights path (can be NULL/empty) */
 int gnubg_initialize(const char* weights_path);
 
-/* Configure evaluation settings */
+/* Evaluation settings, passed with each request so that requests with
+ * different settings can run side by side */
+typedef struct {
+    int eval_plies;      /* Lookahead depth (0-4) */
+    int move_filter;     /* Move filter preset (0 = tiny .. 4 = huge) */
+    int use_pruning;     /* Use the pruning neural networks */
+    double noise;        /* Evaluation noise (0.0 = deterministic) */
+    int use_cache;       /* Look up and store evaluations in the shared cache */
+    int parallel_eval;   /* Spread candidates and top-ply rolls over threads (1+ plies) */
+    unsigned int time_budget_ms; /* Move hints: deepest ranking done in this time (0 = no limit) */
+    const int* cancel;   /* The call fails soon after *cancel becomes nonzero (NULL = never).
+                          * Set it with an atomic store, from any thread. */
+} gnubg_eval_settings;
+
+/* Fill settings with the defaults used by the calls that take none */
+void gnubg_default_settings(gnubg_eval_settings* settings);
+
+/* Change those defaults and the engine thread count. Engine threads are
+ * only started while a rollout runs; a thread_count above 1 also makes
+ * the evals safe for the caller's own threads to use at once. Not meant
+ * to be called while requests are running; pass settings per request
+ * instead. */
 void gnubg_configure(int eval_plies, int move_filter, int use_pruning, double noise, int thread_count);
 
-/* Shutdown and free resources */
+/* Resize the shared evaluation cache to the largest power-of-two number of
+ * entries that fits in size_mb megabytes (at least 1). Empties the cache.
+ * Not meant to be called while requests are running. */
+int gnubg_set_cache_size(unsigned int size_mb);
+
+/* Keep the evaluation cache in a file instead, mapped by every process
+ * that opens it, so that a new process starts with what the others have
+ * cached. A new file is made size_mb megabytes; an existing one keeps its
+ * size. Fails, keeping the current cache, if the file was made with other
+ * weights. Same restrictions as gnubg_set_cache_size(). */
+int gnubg_open_cache_file(const char* path, unsigned int size_mb);
+
+/* Evaluate with int16 copies of the hidden layer weights (on) or the float
+ * weights (off, the default). Equities move by about 0.001 on average.
+ * Empties the caches, and leaves a cache file for an in-memory cache;
+ * same restrictions as gnubg_set_cache_size(). */
+int gnubg_set_quantized(int on);
+
+/* Recent move hints are memoised, so asking for the same position, dice,
+ * cube and settings again returns at once. Requests with noise or without
+ * use_cache bypass the memo. 0 entries turns it off (default 1024). */
+void gnubg_set_hint_memo_size(unsigned int entries);
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned int entries;
+    unsigned int capacity;
+} gnubg_hint_memo_info;
+
+void gnubg_hint_memo_stats(gnubg_hint_memo_info* info);
+
+/* Shutdown and free resources: the engine threads, nets, bearoff
+ * databases and caches. No hint call may be running. gnubg_initialize()
+ * may be called again afterwards. */
 void gnubg_shutdown(void);
 
+/* Zygote mode: fork the initialised engine, so that the child starts with
+ * the nets, bearoff databases, match equity table and a warm evaluation
+ * cache already in memory, shared copy-on-write with the parent. The
+ * engine threads are stopped for the fork and started again on both
+ * sides. No hint call may be running, and no other thread of the caller
+ * may make one in the child, since fork() copies only the calling thread.
+ * Returns as fork() does: the child's pid in the parent, 0 in the child,
+ * -1 on failure or where there is no fork(). */
+int gnubg_fork(void);
+
+/* Give the calling thread its evaluation state. Every thread that makes
+ * hint calls needs it (the hint calls fail without it), so call this once
+ * when the thread starts, after gnubg_initialize(). */
+int gnubg_thread_init(void);
+
+/* Free the calling thread's evaluation state before the thread exits */
+void gnubg_release_thread(void);
+
+/* Runs fn(data, i) for every i below count, on as many threads as it
+ * likes, and returns when all calls are done. Every thread involved needs
+ * gnubg_thread_init(). */
+typedef void (*gnubg_parallel_for)(unsigned int count, void (*fn)(void* data, unsigned int i), void* data);
+
+/* Install the parallel_for used by requests with parallel_eval set;
+ * NULL (the default) keeps every evaluation on its calling thread */
+void gnubg_set_parallel_for(gnubg_parallel_for parallel_for);
+
 /* Board type definition - match GNU Backgammon */
 typedef unsigned int TanBoard[2][25];
 
@@ -36,6 +118,20 @@ int gnubg_hint_move_with_cube(
     void* cube_info      /* Cube information (cubeinfo*) */
 );
 
+/* Get move hints with explicit cube info and settings (NULL uses defaults).
+ * With a time budget the search deepens one ply at a time (0-ply over all
+ * moves, then each ply over the moves the filter kept) and returns the
+ * ranking of the last ply finished when the budget runs out. The ply each
+ * move was scored at is in its esMove.ec.nPlies. */
+int gnubg_hint_move_with_settings(
+    TanBoard board,      /* Board position */
+    int dice[2],         /* Dice values */
+    void* hints_out,     /* Output hints array */
+    int max_hints,       /* Maximum number of hints */
+    void* cube_info,     /* Cube information (cubeinfo*) */
+    const gnubg_eval_settings* settings
+);
+
 /* Get doubling decision */
 int gnubg_hint_double(
     TanBoard board,      /* Board position */
@@ -50,6 +146,70 @@ int gnubg_hint_take(
     void* hint_out       /* Output hint */
 );
 
+/* Doubling and take/drop decisions with settings (NULL uses defaults) */
+int gnubg_hint_double_with_settings(TanBoard board, void* cube_info, void* hint_out,
+                                    const gnubg_eval_settings* settings);
+int gnubg_hint_take_with_settings(TanBoard board, void* cube_info, void* hint_out,
+                                  const gnubg_eval_settings* settings);
+
+/* Rollouts: play the position out many times with the engine choosing the
+ * moves, and average the results. */
+#define GNUBG_ROLLOUT_OUTPUTS 7 /* win, win gammon, win bg, lose gammon, lose bg,
+                                 * cubeless equity, cubeful equity (MWC in a match) */
+
+typedef struct {
+    unsigned int trials;        /* Games per position or move (default 1296) */
+    int truncate_plies;         /* Evaluate after this many plies instead of playing on (0 = play out) */
+    int eval_plies;             /* Lookahead for the moves and cube decisions in the games (default 0) */
+    int cubeful;                /* Play the cube in the games */
+    int variance_reduction;     /* Subtract the luck of each roll, as judged by the evaluation */
+    int quasi_random_dice;      /* Spread the first rolls evenly over the games */
+    unsigned long seed;         /* Same seed and settings, same results */
+    unsigned int threads;       /* Engine threads to use, up to thread_count (0 = all) */
+    unsigned int batch_games;   /* Games each thread plays in lock-step, their candidate moves evaluated
+                                 * in one batch per turn (0 or 1 = one at a time, at most 64) */
+    int stop_on_std;            /* Stop once the equity's standard error is below std_limit ... */
+    float std_limit;
+    unsigned int min_games;     /* ... after at least this many games */
+    int stop_on_jsd;            /* Moves: stop rolling out a move once it is jsd_limit joint standard */
+    float jsd_limit;            /* deviations behind the best one ... */
+    unsigned int min_jsd_games; /* ... after at least this many games */
+    const int* cancel;          /* As in gnubg_eval_settings */
+} gnubg_rollout_settings;
+
+void gnubg_default_rollout_settings(gnubg_rollout_settings* settings);
+
+typedef struct {
+    float mean[GNUBG_ROLLOUT_OUTPUTS];
+    float std_dev[GNUBG_ROLLOUT_OUTPUTS];
+    unsigned int games;         /* Games played */
+    int stopped;                /* Stopped early by stop_on_std or stop_on_jsd */
+} gnubg_rollout_result;
+
+/* Called every two seconds or so while a rollout runs, and once at the
+ * end, for each alternative (the position, or each move) with its results
+ * so far. jsd is how many joint standard deviations a move is behind the
+ * best one (0 for the best, and for position rollouts). Called on the
+ * calling thread, with the games held up until it returns. */
+typedef void (*gnubg_rollout_progress)(void* user_data, int alternative, const gnubg_rollout_result* result,
+                                       float jsd);
+
+/* Roll out the position with the player in cube_info (a cubeinfo*) on
+ * roll. Rollouts run one at a time on up to thread_count engine threads
+ * (of gnubg_configure()), started for the rollout and joined after it; a
+ * second caller waits for the first. */
+int gnubg_rollout_position(TanBoard board, void* cube_info, const gnubg_rollout_settings* settings,
+                           gnubg_rollout_result* result, gnubg_rollout_progress progress, void* user_data);
+
+/* Roll out the best max_moves moves, as ranked by a 0-ply evaluation, for
+ * the dice. Fills hints_out (an array of move) like the hint calls, in
+ * that 0-ply order, with each move's rollout in results; the alternative
+ * numbers passed to progress index the same array. Returns the number of
+ * moves rolled out. */
+int gnubg_rollout_moves(TanBoard board, int dice[2], void* cube_info, const gnubg_rollout_settings* settings,
+                        void* hints_out, gnubg_rollout_result* results, int max_moves,
+                        gnubg_rollout_progress progress, void* user_data);
+
 /* Get GNU Backgammon position ID (14-char string) */
 const char* gnubg_position_id(const TanBoard board);
 
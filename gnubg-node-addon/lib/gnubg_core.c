@@ -6,30 +6,60 @@
 #include "util.h"
 #include "glib-ext.h"
 #include "multithread.h"
+#include "rollout.h"
+#include "dice.h"
 #include "output.h"
 #include <glib.h>
 #include <string.h>
 #include <stdlib.h>
+#if defined(G_OS_UNIX)
+#include <unistd.h>
+#endif
 
 typedef int (*cfunc)(const void *, const void *);
 
 static int g_initialized = 0;
-static evalcontext g_eval_context;
-static movefilter g_move_filter[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+/* Used only when a caller passes no settings of its own */
+static gnubg_eval_settings g_default_settings = { 2, SETTINGS_INTERMEDIATE, 1, 0.0, 1, 0, 0, NULL };
+/* thread_count of gnubg_configure(), the most a rollout may use */
+static int g_engine_threads = 1;
 int fAnalysisRunning = FALSE;
 
-static void ensure_thread_local_data(void) {
+int gnubg_thread_init(void) {
+    if (!g_initialized)
+        return -1;
+
 #if defined(USE_MULTITHREAD)
     if (!g_private_get(td.tlsItem)) {
         TLSSetValue(td.tlsItem, (size_t) MT_CreateThreadLocalData(-1));
     }
+#endif
+    return 0;
+}
+
+/* Hint calls only check that gnubg_thread_init() ran on this thread; the
+ * state itself is created once per thread, not per call */
+static int thread_ready(void) {
+#if defined(USE_MULTITHREAD)
+    return g_private_get(td.tlsItem) != NULL;
 #else
-    if (!td.tld) {
-        td.tld = MT_CreateThreadLocalData(-1);
+    return td.tld != NULL;
+#endif
+}
+
+void gnubg_release_thread(void) {
+#if defined(USE_MULTITHREAD)
+    if (g_private_get(td.tlsItem)) {
+        MT_FreeThreadLocalData(MT_GetTLD());
+        g_private_replace(td.tlsItem, NULL);
     }
 #endif
 }
 
+void gnubg_set_parallel_for(gnubg_parallel_for parallel_for) {
+    fnEvalParallelFor = parallel_for;
+}
+
 static int clamp_int(int value, int min_value, int max_value) {
     if (value < min_value)
         return min_value;
@@ -38,6 +68,205 @@ static int clamp_int(int value, int min_value, int max_value) {
     return value;
 }
 
+/* Translate request settings into an evaluation context and move filters.
+ * Everything ends up on the caller's stack, so concurrent requests never
+ * see each other's settings. */
+static void apply_settings(const gnubg_eval_settings *settings, evalcontext *pec,
+                           movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES]) {
+    const gnubg_eval_settings *ps = settings ? settings : &g_default_settings;
+    int filter_index = clamp_int(ps->move_filter, 0, NUM_MOVEFILTER_SETTINGS - 1);
+
+    *pec = ecBasic;
+    pec->fCubeful = TRUE;
+    pec->nPlies = clamp_int(ps->eval_plies, 0, MAX_FILTER_PLIES);
+    pec->fUsePrune = ps->use_pruning ? TRUE : FALSE;
+    pec->rNoise = (float)ps->noise;
+    pec->fDeterministic = (ps->noise <= 0.0);
+
+    if (aamf)
+        memcpy(aamf, aaamfMoveFilterSettings[filter_index], sizeof(movefilter) * MAX_FILTER_PLIES * MAX_FILTER_PLIES);
+
+    /* The cache itself is shared; a request can only opt out of it */
+    MT_GetTLD()->fNoCache = !ps->use_cache;
+    MT_GetTLD()->fParallelEval = ps->parallel_eval ? TRUE : FALSE;
+    MT_GetTLD()->nDeadline = 0;
+    MT_GetTLD()->pfCancel = ps->cancel;
+}
+
+/* The cancel flag belongs to the caller, so nothing on the thread may
+ * point at it once the call returns */
+static void end_request(void) {
+    MT_GetTLD()->nDeadline = 0;
+    MT_GetTLD()->pfCancel = NULL;
+}
+
+/* A search against a deadline gets a filter stage at every ply below the
+ * top one, so that each ply leaves a ranking to fall back on; a stage the
+ * filter skips keeps all the moves of the stage before */
+static void
+anytime_filters(movefilter aamf[MAX_FILTER_PLIES][MAX_FILTER_PLIES], int plies) {
+    if (plies <= 0)
+        return;
+
+    movefilter *filters = aamf[MIN(plies, MAX_FILTER_PLIES) - 1];
+
+    for (int i = 0; i < plies && i < MAX_FILTER_PLIES; i++)
+        if (filters[i].Accept < 0) {
+            filters[i].Accept = MAX_MOVES;
+            filters[i].Extra = 0;
+            filters[i].Threshold = 0.0f;
+        }
+}
+
+/* Memo of recent move hints, so a position asked for again (stepping back
+ * and forth through a game) costs a lookup rather than a search. The key
+ * holds everything the result depends on; noisy requests and requests
+ * that opted out of the cache bypass it. */
+#define HINT_MEMO_DEFAULT 1024
+
+typedef struct {
+    positionkey key;
+    int dice[2];                /* lower die first */
+    cubeinfo ci;
+    int plies, cubeful, prune, filter;
+} hint_memo_key;
+
+typedef struct {
+    hint_memo_key k;
+    GList link;                 /* in hint_memo.lru, most recent first */
+    unsigned int count;         /* best moves kept, sorted */
+    unsigned int total;         /* legal moves there were */
+    move *moves;
+} hint_memo_entry;
+
+static struct {
+    GMutex lock;
+    GHashTable *table;          /* hint_memo_key -> hint_memo_entry */
+    GQueue lru;
+    unsigned int capacity;
+    unsigned long hits, misses;
+} hint_memo = { .capacity = HINT_MEMO_DEFAULT };
+
+static guint hint_memo_hash(gconstpointer p) {
+    const unsigned char *pb = p;
+    guint hash = 2166136261u;   /* FNV-1a */
+
+    for (size_t i = 0; i < sizeof(hint_memo_key); i++)
+        hash = (hash ^ pb[i]) * 16777619u;
+    return hash;
+}
+
+static gboolean hint_memo_equal(gconstpointer a, gconstpointer b) {
+    return memcmp(a, b, sizeof(hint_memo_key)) == 0;
+}
+
+static void hint_memo_free(gpointer p) {
+    hint_memo_entry *pe = p;
+
+    g_free(pe->moves);
+    g_free(pe);
+}
+
+/* Callers hold hint_memo.lock */
+static void hint_memo_trim(void) {
+    while (hint_memo.lru.length > hint_memo.capacity) {
+        GList *link = hint_memo.lru.tail;
+
+        g_queue_unlink(&hint_memo.lru, link);
+        g_hash_table_remove(hint_memo.table, &((hint_memo_entry *)link->data)->k);
+    }
+}
+
+/* Fills key and returns TRUE if the request may use the memo */
+static int hint_memo_key_for(hint_memo_key *key, const TanBoard board, const int dice[2], const cubeinfo *pci,
+                             const evalcontext *pec, const gnubg_eval_settings *settings) {
+    const gnubg_eval_settings *ps = settings ? settings : &g_default_settings;
+
+    if (pec->rNoise != 0.0f || !ps->use_cache)
+        return FALSE;
+
+    /* zeroed first: the key is hashed and compared as bytes */
+    memset(key, 0, sizeof(*key));
+    PositionKey(board, &key->key);
+    key->dice[0] = MIN(dice[0], dice[1]);
+    key->dice[1] = MAX(dice[0], dice[1]);
+    key->ci = *pci;
+    key->plies = pec->nPlies;
+    key->cubeful = pec->fCubeful;
+    key->prune = pec->fUsePrune;
+    key->filter = clamp_int(ps->move_filter, 0, NUM_MOVEFILTER_SETTINGS - 1);
+    return TRUE;
+}
+
+/* Copies up to max_hints memoised moves; -1 if the memo cannot answer */
+static int hint_memo_lookup(const hint_memo_key *key, move *hints_out, int max_hints) {
+    int count = -1;
+
+    g_mutex_lock(&hint_memo.lock);
+
+    hint_memo_entry *pe = hint_memo.table ? g_hash_table_lookup(hint_memo.table, key) : NULL;
+    /* an entry made for fewer hints than there are moves can't serve more */
+    if (pe && (pe->count >= (unsigned int)max_hints || pe->count == pe->total)) {
+        count = MIN((int)pe->count, max_hints);
+        if (count > 0)
+            memcpy(hints_out, pe->moves, sizeof(move) * count);
+        g_queue_unlink(&hint_memo.lru, &pe->link);
+        g_queue_push_head_link(&hint_memo.lru, &pe->link);
+        hint_memo.hits++;
+    } else
+        hint_memo.misses++;
+
+    g_mutex_unlock(&hint_memo.lock);
+    return count;
+}
+
+static void hint_memo_store(const hint_memo_key *key, const move *moves, unsigned int count, unsigned int total) {
+    g_mutex_lock(&hint_memo.lock);
+
+    if (hint_memo.capacity > 0) {
+        if (!hint_memo.table)
+            hint_memo.table = g_hash_table_new_full(hint_memo_hash, hint_memo_equal, NULL, hint_memo_free);
+
+        hint_memo_entry *pe = g_hash_table_lookup(hint_memo.table, key);
+        if (pe) {
+            /* another thread got here first */
+            g_free(pe->moves);
+            g_queue_unlink(&hint_memo.lru, &pe->link);
+        } else {
+            pe = g_new0(hint_memo_entry, 1);
+            pe->k = *key;
+            pe->link.data = pe;
+            g_hash_table_insert(hint_memo.table, &pe->k, pe);
+        }
+
+        pe->moves = g_new(move, count);
+        memcpy(pe->moves, moves, sizeof(move) * count);
+        pe->count = count;
+        pe->total = total;
+        g_queue_push_head_link(&hint_memo.lru, &pe->link);
+        hint_memo_trim();
+    }
+
+    g_mutex_unlock(&hint_memo.lock);
+}
+
+void gnubg_set_hint_memo_size(unsigned int entries) {
+    g_mutex_lock(&hint_memo.lock);
+    hint_memo.capacity = entries;
+    if (hint_memo.table)
+        hint_memo_trim();
+    g_mutex_unlock(&hint_memo.lock);
+}
+
+void gnubg_hint_memo_stats(gnubg_hint_memo_info *info) {
+    g_mutex_lock(&hint_memo.lock);
+    info->hits = hint_memo.hits;
+    info->misses = hint_memo.misses;
+    info->entries = hint_memo.lru.length;
+    info->capacity = hint_memo.capacity;
+    g_mutex_unlock(&hint_memo.lock);
+}
+
 static void set_data_dirs_from_weights(const char *weights_path) {
     if (!weights_path || !weights_path[0])
         return;
@@ -78,55 +307,135 @@ int gnubg_initialize(const char *weights_path) {
     /* EvalInitialise sets neural net sizes needed by thread-local buffers. */
     MT_InitThreads();
 
+    /* rollouts seed a copy of it per thread and trial */
+    if (!rngctxRollout)
+        rngctxRollout = InitRNG(NULL, NULL, FALSE, RNG_MERSENNE);
+
     g_free(weights);
     g_free(weights_binary);
 
-    g_eval_context = ecBasic;
-    g_eval_context.fCubeful = TRUE;
-    g_eval_context.nPlies = 2;
-    g_eval_context.fUsePrune = TRUE;
-    g_eval_context.rNoise = 0.0f;
-    g_eval_context.fDeterministic = TRUE;
-    memcpy(g_move_filter, aaamfMoveFilterSettings[SETTINGS_INTERMEDIATE], sizeof(g_move_filter));
-
     g_initialized = 1;
     return 0;
 }
 
+void gnubg_default_settings(gnubg_eval_settings *settings) {
+    if (settings)
+        *settings = g_default_settings;
+}
+
 void gnubg_configure(int eval_plies, int move_filter, int use_pruning, double noise, int thread_count) {
-    int plies = clamp_int(eval_plies, 0, MAX_FILTER_PLIES);
-    int filter_index = clamp_int(move_filter, 0, NUM_MOVEFILTER_SETTINGS - 1);
     int threads = clamp_int(thread_count, 0, MAX_NUMTHREADS);
 
-    g_eval_context.fCubeful = TRUE;
-    g_eval_context.nPlies = plies;
-    g_eval_context.fUsePrune = use_pruning ? TRUE : FALSE;
-    g_eval_context.rNoise = (float)noise;
-    g_eval_context.fDeterministic = (noise <= 0.0);
-
-    memcpy(g_move_filter, aaamfMoveFilterSettings[filter_index], sizeof(g_move_filter));
+    g_default_settings.eval_plies = clamp_int(eval_plies, 0, MAX_FILTER_PLIES);
+    g_default_settings.move_filter = clamp_int(move_filter, 0, NUM_MOVEFILTER_SETTINGS - 1);
+    g_default_settings.use_pruning = use_pruning ? 1 : 0;
+    g_default_settings.noise = noise;
 
     if (threads > 0) {
-        MT_SetNumThreads((unsigned int)threads);
+        g_engine_threads = threads;
+#if defined(USE_MULTITHREAD)
+        /* The threads themselves are only started for a rollout, but the
+         * caller's own threads evaluate at the same time from now on */
+        MT_SetLocking(threads != 1);
+#endif
     }
 }
 
+/* Largest power-of-two number of cache entries that fits in size_mb */
+static unsigned int cache_entries(unsigned int size_mb) {
+    size_t const cb = (size_t)(size_mb > 0 ? size_mb : 1) << 20;
+    unsigned int nodes = 1;
+
+    /* Each node holds two entries */
+    while (nodes < (1u << 30) && (size_t)nodes * 2 * sizeof(cacheNode) <= cb)
+        nodes *= 2;
+
+    return 2 * nodes;
+}
+
+int gnubg_set_cache_size(unsigned int size_mb) {
+    if (!g_initialized)
+        return -1;
+
+    if (EvalCacheResize(cache_entries(size_mb)) < 0) {
+        /* The old table is gone already; fall back to the default size */
+        EvalCacheResize(0x1 << CACHE_SIZE_DEFAULT);
+        return -1;
+    }
+    return 0;
+}
+
+int gnubg_open_cache_file(const char *path, unsigned int size_mb) {
+    if (!g_initialized || !path || !path[0])
+        return -1;
+
+    return EvalCacheOpen(path, cache_entries(size_mb)) < 0 ? -1 : 0;
+}
+
+int gnubg_set_quantized(int on) {
+    if (!g_initialized || EvalSetQuantized(on) != 0)
+        return -1;
+
+    /* memoised hints came from the other nets */
+    g_mutex_lock(&hint_memo.lock);
+    if (hint_memo.table) {
+        g_hash_table_remove_all(hint_memo.table);
+        g_queue_init(&hint_memo.lru);
+    }
+    g_mutex_unlock(&hint_memo.lock);
+    return 0;
+}
+
 void gnubg_shutdown(void) {
     if (!g_initialized)
         return;
 
-    /* MT_Close/EvalShutdown crash in embedded use; skip to keep teardown safe. */
-    /* MT_Close(); */
-    /* EvalShutdown(); */
+    g_mutex_lock(&hint_memo.lock);
+    if (hint_memo.table) {
+        g_queue_init(&hint_memo.lru);
+        g_hash_table_destroy(hint_memo.table);
+        hint_memo.table = NULL;
+    }
+    g_mutex_unlock(&hint_memo.lock);
+
+    /* Join the engine threads before the nets and caches they use go
+     * away. Threads of the caller must have stopped making hint calls;
+     * their state is theirs to free with gnubg_release_thread(). */
+    gnubg_release_thread();
+    MT_Close();
+    EvalShutdown();
 
     g_initialized = 0;
 }
 
-int gnubg_hint_move_with_cube(TanBoard board, int dice[2], void *hints_out, int max_hints, void *cube_info) {
-    if (!g_initialized || !hints_out || max_hints <= 0)
+int gnubg_fork(void) {
+#if defined(G_OS_UNIX)
+    if (!g_initialized)
         return -1;
 
-    ensure_thread_local_data();
+#if defined(USE_MULTITHREAD)
+    /* fork() copies only the calling thread, so the engine threads are
+     * joined first and started again on both sides */
+    unsigned int const threads = MT_GetNumThreads();
+    MT_CloseThreads();
+#endif
+
+    pid_t const pid = fork();
+
+#if defined(USE_MULTITHREAD)
+    if (threads)
+        MT_ResizeThreads(threads);
+#endif
+    return (int)pid;
+#else
+    return -1;
+#endif
+}
+
+int gnubg_hint_move_with_settings(TanBoard board, int dice[2], void *hints_out, int max_hints, void *cube_info,
+                                  const gnubg_eval_settings *settings) {
+    if (!g_initialized || !thread_ready() || !hints_out || max_hints <= 0)
+        return -1;
 
     movelist ml;
     memset(&ml, 0, sizeof(ml));
@@ -139,40 +448,78 @@ int gnubg_hint_move_with_cube(TanBoard board, int dice[2], void *hints_out, int
         ci.bgv = bgvDefault;
     }
 
-    evalcontext ec = g_eval_context;
+    evalcontext ec;
     movefilter filters[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
-    memcpy(filters, g_move_filter, sizeof(filters));
+    apply_settings(settings, &ec, filters);
+
+    hint_memo_key key;
+    int memo = hint_memo_key_for(&key, (ConstTanBoard)board, dice, &ci, &ec, settings);
+    if (memo) {
+        /* memoised hints were searched to full depth, so they do for a
+         * request with a time budget too */
+        int count = hint_memo_lookup(&key, hints_out, max_hints);
+        if (count >= 0) {
+            end_request();
+            return count;
+        }
+    }
+
+    gint64 deadline = 0;
+    if (settings && settings->time_budget_ms > 0) {
+        deadline = g_get_monotonic_time() + (gint64)settings->time_budget_ms * 1000;
+        anytime_filters(filters, ec.nPlies);
+        MT_GetTLD()->nDeadline = deadline;
+    }
 
-    if (FindnSaveBestMoves(&ml, dice[0], dice[1], (ConstTanBoard)board, NULL, 0.0f, &ci, &ec, filters) < 0) {
+    int const found = FindnSaveBestMoves(&ml, dice[0], dice[1], (ConstTanBoard)board, NULL, 0.0f, &ci, &ec, filters);
+    end_request();
+
+    if (found < 0) {
         if (ml.amMoves)
             g_free(ml.amMoves);
         return -1;
     }
 
-    if (!ml.cMoves || !ml.amMoves)
+    /* a search the deadline cut short is not the answer for the memo */
+    if (deadline && g_get_monotonic_time() >= deadline)
+        memo = FALSE;
+
+    if (!ml.cMoves || !ml.amMoves) {
+        if (memo)
+            hint_memo_store(&key, NULL, 0, 0);
         return 0;
+    }
 
     qsort(ml.amMoves, ml.cMoves, sizeof(move), (cfunc) CompareMoves);
 
     int copy_count = (ml.cMoves < (unsigned int)max_hints) ? (int)ml.cMoves : max_hints;
     memcpy(hints_out, ml.amMoves, sizeof(move) * copy_count);
+    if (memo)
+        hint_memo_store(&key, ml.amMoves, copy_count, ml.cMoves);
 
     g_free(ml.amMoves);
     return copy_count;
 }
 
+int gnubg_hint_move_with_cube(TanBoard board, int dice[2], void *hints_out, int max_hints, void *cube_info) {
+    return gnubg_hint_move_with_settings(board, dice, hints_out, max_hints, cube_info, NULL);
+}
+
 int gnubg_hint_move(TanBoard board, int dice[2], void *hints_out, int max_hints) {
     return gnubg_hint_move_with_cube(board, dice, hints_out, max_hints, NULL);
 }
 
-static int evaluate_cube(const TanBoard board, cubeinfo *pci, float *out_no_double,
-                         float *out_take, float *out_drop) {
+static int evaluate_cube(const TanBoard board, cubeinfo *pci, const gnubg_eval_settings *settings,
+                         float *out_no_double, float *out_take, float *out_drop) {
     float aarOutput[2][NUM_ROLLOUT_OUTPUTS];
     float arDouble[4];
-    evalcontext ec = g_eval_context;
-    ec.fCubeful = TRUE;
+    evalcontext ec;
+
+    apply_settings(settings, &ec, NULL);
 
-    if (GeneralCubeDecisionE(aarOutput, board, pci, &ec, NULL) < 0)
+    int const decided = GeneralCubeDecisionE(aarOutput, board, pci, &ec, NULL);
+    end_request();
+    if (decided < 0)
         return -1;
 
     cubedecision decision = FindCubeDecision(arDouble, aarOutput, pci);
@@ -187,28 +534,242 @@ static int evaluate_cube(const TanBoard board, cubeinfo *pci, float *out_no_doub
     return (int)decision;
 }
 
-int gnubg_hint_double(TanBoard board, void *cube_info, void *hint_out) {
-    if (!g_initialized || !cube_info)
+int gnubg_hint_double_with_settings(TanBoard board, void *cube_info, void *hint_out,
+                                    const gnubg_eval_settings *settings) {
+    if (!g_initialized || !thread_ready() || !cube_info)
         return -1;
 
-    ensure_thread_local_data();
-
     cubeinfo ci = *(cubeinfo *)cube_info;
     float *equity_out = (float *)hint_out;
 
-    return evaluate_cube(board, &ci, equity_out, NULL, NULL);
+    return evaluate_cube(board, &ci, settings, equity_out, NULL, NULL);
+}
+
+int gnubg_hint_double(TanBoard board, void *cube_info, void *hint_out) {
+    return gnubg_hint_double_with_settings(board, cube_info, hint_out, NULL);
+}
+
+int gnubg_hint_take_with_settings(TanBoard board, void *cube_info, void *hint_out,
+                                  const gnubg_eval_settings *settings) {
+    if (!g_initialized || !thread_ready() || !cube_info || !hint_out)
+        return -1;
+
+    cubeinfo ci = *(cubeinfo *)cube_info;
+    float *equities = (float *)hint_out;
+
+    return evaluate_cube(board, &ci, settings, NULL, &equities[0], &equities[1]);
 }
 
 int gnubg_hint_take(TanBoard board, void *cube_info, void *hint_out) {
-    if (!g_initialized || !cube_info || !hint_out)
+    return gnubg_hint_take_with_settings(board, cube_info, hint_out, NULL);
+}
+
+/* rollout.c keeps the rollout in progress in globals (rcRollout, its
+ * ro_* state, ms.nMatchTo for the equity conversions), so one rollout
+ * runs at a time */
+static GMutex rollout_lock;
+
+#define ROLLOUT_MOVE_FILTER 2   /* normal, as in the gnubg defaults */
+
+void gnubg_default_rollout_settings(gnubg_rollout_settings *settings) {
+    if (!settings)
+        return;
+
+    memset(settings, 0, sizeof(*settings));
+    settings->trials = 1296;
+    settings->cubeful = 1;
+    settings->variance_reduction = 1;
+    settings->quasi_random_dice = 1;
+    settings->std_limit = 0.01f;
+    settings->min_games = 324;
+    settings->jsd_limit = 2.33f;
+    settings->min_jsd_games = 324;
+}
+
+static void rollout_context(const gnubg_rollout_settings *ps, rolloutcontext *prc) {
+    evalcontext const ec = { .fCubeful = ps->cubeful ? TRUE : FALSE,
+                             .nPlies = clamp_int(ps->eval_plies, 0, MAX_FILTER_PLIES),
+                             .fUsePrune = TRUE,
+                             .fDeterministic = TRUE };
+    int const truncate = clamp_int(ps->truncate_plies, 0, 0xffff);
+
+    memset(prc, 0, sizeof(*prc));
+    for (int i = 0; i < 2; i++) {
+        prc->aecCube[i] = prc->aecChequer[i] = ec;
+        prc->aecCubeLate[i] = prc->aecChequerLate[i] = ec;
+        memcpy(prc->aaamfChequer[i], aaamfMoveFilterSettings[ROLLOUT_MOVE_FILTER], sizeof(prc->aaamfChequer[i]));
+        memcpy(prc->aaamfLate[i], aaamfMoveFilterSettings[ROLLOUT_MOVE_FILTER], sizeof(prc->aaamfLate[i]));
+    }
+    prc->aecCubeTrunc = prc->aecChequerTrunc = ec;
+
+    prc->fCubeful = ec.fCubeful;
+    prc->fVarRedn = ps->variance_reduction ? TRUE : FALSE;
+    prc->fRotate = ps->quasi_random_dice ? TRUE : FALSE;
+    prc->fTruncBearoff2 = prc->fTruncBearoffOS = TRUE;
+    prc->fDoTruncate = truncate > 0;
+    prc->nTruncate = (unsigned short)truncate;
+    prc->nTrials = ps->trials > 0 ? ps->trials : 1;
+    prc->nLate = 5;
+    prc->rngRollout = RNG_MERSENNE;
+    prc->nSeed = ps->seed;
+    prc->fStopOnSTD = ps->stop_on_std ? TRUE : FALSE;
+    prc->nMinimumGames = ps->min_games;
+    prc->rStdLimit = ps->std_limit;
+    prc->fStopOnJsd = prc->fStopMoveOnJsd = ps->stop_on_jsd ? TRUE : FALSE;
+    prc->nMinimumJsdGames = ps->min_jsd_games;
+    prc->rJsdLimit = ps->jsd_limit;
+}
+
+typedef struct {
+    gnubg_rollout_result *results;
+    gnubg_rollout_progress progress;
+    void *user_data;
+} rollout_request;
+
+/* The rolloutprogressfunc for RolloutGeneral. It is also called once at
+ * the end, so the results it keeps are the final ones. */
+static void rollout_progress(float aarOutput[][NUM_ROLLOUT_OUTPUTS], float aarStdDev[][NUM_ROLLOUT_OUTPUTS],
+                             const rolloutcontext *prc, const cubeinfo aci[], unsigned int initial_game_count,
+                             const int iGame, const int iAlternative, const int nRank, const float rJsd,
+                             const int fStopped, const int fShowRanks, int fCubeRollout, void *pUserData) {
+    rollout_request *prr = pUserData;
+    gnubg_rollout_result *pr = &prr->results[iAlternative];
+
+    (void) prc;
+    (void) aci;
+    (void) initial_game_count;
+    (void) nRank;
+    (void) fShowRanks;
+    (void) fCubeRollout;
+
+    memcpy(pr->mean, aarOutput[iAlternative], sizeof(pr->mean));
+    memcpy(pr->std_dev, aarStdDev[iAlternative], sizeof(pr->std_dev));
+    pr->games = iGame >= 0 ? (unsigned int)iGame + 1 : 0;
+    pr->stopped = fStopped;
+
+    if (prr->progress && pr->games > 0)
+        prr->progress(prr->user_data, iAlternative, pr, rJsd);
+}
+
+/* Runs the rollout with the globals of rollout.c set from settings. The
+ * progress callback fills results[], one per alternative. */
+static int rollout_run(int (*run)(void *data), void *data, const gnubg_rollout_settings *settings,
+                       const cubeinfo *pci) {
+    gnubg_rollout_settings defaults;
+    int ret;
+
+    if (!settings) {
+        gnubg_default_rollout_settings(&defaults);
+        settings = &defaults;
+    }
+
+    g_mutex_lock(&rollout_lock);
+
+    rollout_context(settings, &rcRollout);
+    ms.nMatchTo = pci->nMatchTo;
+    cRolloutThreads = settings->threads;
+    cRolloutBatch = MIN(settings->batch_games, MAX_ROLLOUT_BATCH);
+    pfRolloutCancel = settings->cancel;
+    fShowProgress = TRUE;       /* or RolloutGeneral reports nothing */
+    outputoff();
+#if defined(USE_MULTITHREAD)
+    /* the engine threads only exist while a rollout runs, so they do not
+     * add to the caller's threads the rest of the time */
+    MT_ResizeThreads(settings->threads > 0 ? MIN(settings->threads, (unsigned int)g_engine_threads)
+                                           : (unsigned int)g_engine_threads);
+#endif
+
+    ret = run(data);
+    if (settings->cancel && MT_SafeGet(settings->cancel))
+        ret = -1;
+
+    outputon();
+    fShowProgress = FALSE;
+    pfRolloutCancel = NULL;
+    cRolloutBatch = 0;
+    cRolloutThreads = 0;
+    ms.nMatchTo = 0;
+#if defined(USE_MULTITHREAD)
+    MT_CloseThreads();
+#endif
+
+    g_mutex_unlock(&rollout_lock);
+    return ret;
+}
+
+typedef struct {
+    const TanBoard *pBoard;
+    const cubeinfo *pci;
+    rollout_request rr;
+} position_rollout;
+
+static int run_position_rollout(void *data) {
+    position_rollout *ppr = data;
+    float arOutput[NUM_ROLLOUT_OUTPUTS], arStdDev[NUM_ROLLOUT_OUTPUTS];
+
+    return GeneralEvaluationR(arOutput, arStdDev, NULL, *ppr->pBoard, ppr->pci, &rcRollout, rollout_progress,
+                              &ppr->rr);
+}
+
+int gnubg_rollout_position(TanBoard board, void *cube_info, const gnubg_rollout_settings *settings,
+                           gnubg_rollout_result *result, gnubg_rollout_progress progress, void *user_data) {
+    if (!g_initialized || !thread_ready() || !cube_info || !result)
         return -1;
 
-    ensure_thread_local_data();
+    cubeinfo const ci = *(cubeinfo *)cube_info;
+    position_rollout pr = { (const TanBoard *)board, &ci, { result, progress, user_data } };
+
+    memset(result, 0, sizeof(*result));
+    return rollout_run(run_position_rollout, &pr, settings, &ci) < 0 ? -1 : 0;
+}
+
+typedef struct {
+    move **ppm;
+    cubeinfo **ppci;
+    int cMoves;
+    rollout_request rr;
+} moves_rollout;
+
+static int run_moves_rollout(void *data) {
+    moves_rollout *pmr = data;
+
+    return ScoreMoveRollout(pmr->ppm, pmr->ppci, pmr->cMoves, rollout_progress, &pmr->rr);
+}
+
+int gnubg_rollout_moves(TanBoard board, int dice[2], void *cube_info, const gnubg_rollout_settings *settings,
+                        void *hints_out, gnubg_rollout_result *results, int max_moves,
+                        gnubg_rollout_progress progress, void *user_data) {
+    if (!g_initialized || !thread_ready() || !cube_info || !hints_out || !results || max_moves <= 0)
+        return -1;
 
     cubeinfo ci = *(cubeinfo *)cube_info;
-    float *equities = (float *)hint_out;
+    move *amMoves = hints_out;
+
+    /* the candidates, from a 0-ply ranking of every legal move */
+    gnubg_eval_settings candidates = g_default_settings;
+    candidates.eval_plies = 0;
+    candidates.cancel = settings ? settings->cancel : NULL;
+
+    int const count = gnubg_hint_move_with_settings(board, dice, amMoves, max_moves, &ci, &candidates);
+    if (count <= 0)
+        return count;
+
+    move **ppm = g_new(move *, count);
+    cubeinfo **ppci = g_new(cubeinfo *, count);
+
+    for (int i = 0; i < count; i++) {
+        amMoves[i].esMove.et = EVAL_NONE;       /* a new rollout, not an extension */
+        ppm[i] = &amMoves[i];
+        ppci[i] = &ci;
+    }
+    memset(results, 0, sizeof(gnubg_rollout_result) * count);
+
+    moves_rollout mr = { ppm, ppci, count, { results, progress, user_data } };
+    int const ret = rollout_run(run_moves_rollout, &mr, settings, &ci);
 
-    return evaluate_cube(board, &ci, NULL, &equities[0], &equities[1]);
+    g_free(ppci);
+    g_free(ppm);
+    return ret < 0 ? -1 : count;
 }
 
 const char *gnubg_position_id(const TanBoard board) {
@@ -95,7 +95,14 @@ copy_or_generate_ts0() {
     # Try generating with makebearoff
     if command -v makebearoff &> /dev/null; then
         echo "Generating gnubg_ts0.bd (two-sided 6x6 bearoff database)..."
-        echo "This may take a few minutes..."
+        # makebearoff builds with --threads use every processor by default.
+        # They fall back to one thread above --max-memory (2048 MB), which
+        # only the 15-chequer two-sided database (-t 6x15, ~22500 MB) exceeds.
+        if makebearoff --help 2>&1 | grep -q -- "--threads"; then
+            echo "Generating on $(getconf _NPROCESSORS_ONLN 2>/dev/null || echo 1) threads..."
+        else
+            echo "This may take a few minutes..."
+        fi
         makebearoff -t 6x6 -f "$target"
         echo "Generated gnubg_ts0.bd"
         return 0
@@ -1,4 +1,5 @@
 #include <napi.h>
+#include <algorithm>
 #include "hint_wrapper.h"
 
 extern "C" {
@@ -16,20 +17,33 @@ struct ModuleState {
 
 extern ModuleState g_state;
 
+// Config for one request: the configured defaults, overridden by whatever
+// the request object carries in its own "config" field
+static HintConfig RequestConfig(const Napi::Object& request) {
+    if (request.Has("config") && request.Get("config").IsObject()) {
+        return HintConfig::fromJsObject(request.Get("config").As<Napi::Object>(), g_state.config);
+    }
+    return g_state.config;
+}
+
 // Initialize the GNU Backgammon engine
 Napi::Value Initialize(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
-    if (info.Length() < 2 || !info[1].IsFunction()) {
-        Napi::TypeError::New(env, "Expected (weightsPath, callback)").ThrowAsJavaScriptException();
+    const size_t callbackIndex = info.Length() > 2 ? 2 : 1;
+    if (info.Length() < 2 || !info[callbackIndex].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (weightsPath, [config], callback)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
     std::string weightsPath = info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : "";
-    Napi::Function callback = info[1].As<Napi::Function>();
+    HintConfig config = callbackIndex == 2 && info[1].IsObject()
+        ? HintConfig::fromJsObject(info[1].As<Napi::Object>(), g_state.config)
+        : g_state.config;
+    Napi::Function callback = info[callbackIndex].As<Napi::Function>();
 
     // Initialize in a worker thread to avoid blocking
-    auto* asyncWorker = new InitializeWorker(callback, weightsPath);
+    auto* asyncWorker = new InitializeWorker(callback, weightsPath, config);
     asyncWorker->Queue();
 
     return env.Undefined();
@@ -44,20 +58,26 @@ Napi::Value Configure(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    if (info.Length() < 1 || !info[0].IsObject()) {
-        Napi::TypeError::New(env, "Expected configuration object").ThrowAsJavaScriptException();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (config, callback)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
     Napi::Object config = info[0].As<Napi::Object>();
+    Napi::Function callback = info[1].As<Napi::Function>();
 
-    // Update configuration using functional approach
+    // Update configuration using functional approach; the defaults apply
+    // to requests queued from now on. A new thread count, cache or net mode
+    // waits for running evaluations, so it is set up in a worker thread;
+    // requests queued meanwhile wait for it.
     g_state.config = HintConfig::fromJsObject(config);
+    auto* asyncWorker = new ConfigureWorker(callback, g_state.config);
+    asyncWorker->Queue();
 
     return env.Undefined();
 }
 
-// Get move hints
+// Get move hints; returns a function that cancels the request
 Napi::Value GetMoveHints(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
 
@@ -71,15 +91,63 @@ Napi::Value GetMoveHints(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    auto request = HintRequest::fromJsObject(info[0].As<Napi::Object>());
+    Napi::Object requestObj = info[0].As<Napi::Object>();
+    auto request = HintRequest::fromJsObject(requestObj);
     int maxHints = info[1].As<Napi::Number>().Int32Value();
     Napi::Function callback = info[2].As<Napi::Function>();
 
-    // Execute in worker thread
-    auto* asyncWorker = new MoveHintWorker(callback, request, maxHints, g_state.config);
+    // Execute on the addon's thread pool
+    auto* asyncWorker = new MoveHintWorker(callback, request, maxHints, RequestConfig(requestObj));
+    Napi::Function cancel = asyncWorker->CancelFunction();
     asyncWorker->Queue();
 
-    return env.Undefined();
+    return cancel;
+}
+
+// Get move hints for an array of positions
+Napi::Value GetMoveHintsBatch(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!g_state.initialized) {
+        Napi::Error::New(env, "Engine not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 3 || !info[0].IsArray() || !info[2].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (requests, maxHints, callback[, onProgress])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Array requestArr = info[0].As<Napi::Array>();
+    int maxHints = info[1].As<Napi::Number>().Int32Value();
+    Napi::Function callback = info[2].As<Napi::Function>();
+    Napi::Function progress = info.Length() > 3 && info[3].IsFunction()
+        ? info[3].As<Napi::Function>()
+        : Napi::Function();
+
+    std::vector<HintRequest> requests;
+    std::vector<HintConfig> configs;
+    requests.reserve(requestArr.Length());
+    configs.reserve(requestArr.Length());
+    for (uint32_t i = 0; i < requestArr.Length(); i++) {
+        Napi::Value value = requestArr.Get(i);
+        if (!value.IsObject()) {
+            Napi::TypeError::New(env, "Each request must be an object").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+        Napi::Object requestObj = value.As<Napi::Object>();
+        requests.push_back(HintRequest::fromJsObject(requestObj));
+        configs.push_back(RequestConfig(requestObj));
+    }
+
+    // Positions run on the addon's pool, so its size (the configured
+    // threadCount) bounds the parallelism, not a per-request override
+    auto* asyncWorker = new BatchMoveHintWorker(callback, progress, std::move(requests), std::move(configs),
+                                                maxHints);
+    Napi::Function cancel = asyncWorker->CancelFunction();
+    asyncWorker->Queue();
+
+    return cancel;
 }
 
 // Get double hint
@@ -96,14 +164,16 @@ Napi::Value GetDoubleHint(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    auto request = HintRequest::fromJsObject(info[0].As<Napi::Object>());
+    Napi::Object requestObj = info[0].As<Napi::Object>();
+    auto request = HintRequest::fromJsObject(requestObj);
     Napi::Function callback = info[1].As<Napi::Function>();
 
-    // Execute in worker thread
-    auto* asyncWorker = new DoubleHintWorker(callback, request, g_state.config);
+    // Execute on the addon's thread pool
+    auto* asyncWorker = new DoubleHintWorker(callback, request, RequestConfig(requestObj));
+    Napi::Function cancel = asyncWorker->CancelFunction();
     asyncWorker->Queue();
 
-    return env.Undefined();
+    return cancel;
 }
 
 // Get take hint
@@ -120,14 +190,86 @@ Napi::Value GetTakeHint(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    auto request = HintRequest::fromJsObject(info[0].As<Napi::Object>());
+    Napi::Object requestObj = info[0].As<Napi::Object>();
+    auto request = HintRequest::fromJsObject(requestObj);
     Napi::Function callback = info[1].As<Napi::Function>();
 
-    // Execute in worker thread
-    auto* asyncWorker = new TakeHintWorker(callback, request, g_state.config);
+    // Execute on the addon's thread pool
+    auto* asyncWorker = new TakeHintWorker(callback, request, RequestConfig(requestObj));
+    Napi::Function cancel = asyncWorker->CancelFunction();
     asyncWorker->Queue();
 
-    return env.Undefined();
+    return cancel;
+}
+
+// Roll out a position (maxMoves 0) or its best moves; shared by the two
+// exports below, which differ only in their arguments
+static Napi::Value QueueRollout(const Napi::Object& requestObj, int maxMoves, const Napi::Value& config,
+                                Napi::Function callback, const Napi::Value& progress) {
+    auto request = HintRequest::fromJsObject(requestObj);
+    RolloutConfig rolloutConfig = config.IsObject()
+        ? RolloutConfig::fromJsObject(config.As<Napi::Object>())
+        : RolloutConfig();
+    Napi::Function onProgress = progress.IsFunction() ? progress.As<Napi::Function>() : Napi::Function();
+
+    auto* asyncWorker = new RolloutWorker(callback, onProgress, request, maxMoves, rolloutConfig);
+    Napi::Function cancel = asyncWorker->CancelFunction();
+    asyncWorker->Queue();
+
+    return cancel;
+}
+
+// Roll out a position; returns a function that cancels the rollout
+Napi::Value RolloutPosition(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!g_state.initialized) {
+        Napi::Error::New(env, "Engine not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 3 || !info[0].IsObject() || !info[2].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (request, config, callback[, onProgress])").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    return QueueRollout(info[0].As<Napi::Object>(), 0, info[1], info[2].As<Napi::Function>(),
+                        info.Length() > 3 ? info[3] : env.Undefined());
+}
+
+// Roll out the best moves for a roll
+Napi::Value RolloutMoves(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if (!g_state.initialized) {
+        Napi::Error::New(env, "Engine not initialized").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (info.Length() < 4 || !info[0].IsObject() || !info[3].IsFunction()) {
+        Napi::TypeError::New(env, "Expected (request, maxMoves, config, callback[, onProgress])")
+            .ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    int maxMoves = std::max(info[1].As<Napi::Number>().Int32Value(), 1);
+    return QueueRollout(info[0].As<Napi::Object>(), maxMoves, info[2], info[3].As<Napi::Function>(),
+                        info.Length() > 4 ? info[4] : env.Undefined());
+}
+
+// Counters of the move hint memo
+Napi::Value GetHintMemoStats(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    gnubg_hint_memo_info memo;
+    gnubg_hint_memo_stats(&memo);
+
+    Napi::Object stats = Napi::Object::New(env);
+    stats.Set("hits", Napi::Number::New(env, static_cast<double>(memo.hits)));
+    stats.Set("misses", Napi::Number::New(env, static_cast<double>(memo.misses)));
+    stats.Set("entries", Napi::Number::New(env, memo.entries));
+    stats.Set("capacity", Napi::Number::New(env, memo.capacity));
+    return stats;
 }
 
 // Get position ID from board
@@ -210,8 +352,12 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
     exports.Set("initialize", Napi::Function::New(env, Initialize));
     exports.Set("configure", Napi::Function::New(env, Configure));
     exports.Set("getMoveHints", Napi::Function::New(env, GetMoveHints));
+    exports.Set("getMoveHintsBatch", Napi::Function::New(env, GetMoveHintsBatch));
     exports.Set("getDoubleHint", Napi::Function::New(env, GetDoubleHint));
     exports.Set("getTakeHint", Napi::Function::New(env, GetTakeHint));
+    exports.Set("rolloutPosition", Napi::Function::New(env, RolloutPosition));
+    exports.Set("rolloutMoves", Napi::Function::New(env, RolloutMoves));
+    exports.Set("getHintMemoStats", Napi::Function::New(env, GetHintMemoStats));
     exports.Set("getPositionId", Napi::Function::New(env, GetPositionId));
     exports.Set("decodePositionId", Napi::Function::New(env, DecodePositionId));
     exports.Set("shutdown", Napi::Function::New(env, Shutdown));
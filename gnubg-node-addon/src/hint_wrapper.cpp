@@ -1,9 +1,11 @@
 #include "hint_wrapper.h"
+#include "thread_pool.h"
 #include <functional>
 #include <algorithm>
 #include <stdexcept>
 #include <exception>
 #include <cstring>
+#include <optional>
 
 // Global state definition
 namespace gnubg_addon {
@@ -98,22 +100,187 @@ bool decode_position_id(const std::string& positionId, TanBoard board) {
     return playerIndex == 2 && pointIndex == 0;
 }
 
+gnubg_eval_settings to_eval_settings(const gnubg_addon::HintConfig& config, const int* cancel) {
+    gnubg_eval_settings settings;
+    settings.eval_plies = config.evalPlies;
+    settings.move_filter = config.moveFilter;
+    settings.use_pruning = config.usePruning ? 1 : 0;
+    settings.noise = config.noise;
+    settings.use_cache = config.useCache ? 1 : 0;
+    settings.parallel_eval = config.parallelEval ? 1 : 0;
+    settings.time_budget_ms = config.timeBudgetMs > 0 ? static_cast<unsigned int>(config.timeBudgetMs) : 0;
+    settings.cancel = cancel;
+    return settings;
+}
+
+gnubg_rollout_settings to_rollout_settings(const gnubg_addon::RolloutConfig& config, const int* cancel) {
+    gnubg_rollout_settings settings;
+    gnubg_default_rollout_settings(&settings);
+    settings.trials = static_cast<unsigned int>(std::max(config.trials, 1));
+    settings.truncate_plies = std::max(config.truncatePlies, 0);
+    settings.eval_plies = config.evalPlies;
+    settings.cubeful = config.cubeful ? 1 : 0;
+    settings.variance_reduction = config.varianceReduction ? 1 : 0;
+    settings.quasi_random_dice = config.quasiRandomDice ? 1 : 0;
+    settings.seed = static_cast<unsigned long>(std::max(config.seed, 0.0));
+    settings.threads = static_cast<unsigned int>(std::max(config.threads, 0));
+    settings.batch_games = static_cast<unsigned int>(std::max(config.batchGames, 0));
+    settings.stop_on_std = config.stopOnStd ? 1 : 0;
+    settings.std_limit = static_cast<float>(config.stdLimit);
+    settings.min_games = static_cast<unsigned int>(std::max(config.minGames, 0));
+    settings.stop_on_jsd = config.stopOnJsd ? 1 : 0;
+    settings.jsd_limit = static_cast<float>(config.jsdLimit);
+    settings.min_jsd_games = static_cast<unsigned int>(std::max(config.minJsdGames, 0));
+    settings.cancel = cancel;
+    return settings;
+}
+
+// config with its time budget cut by the time the request has waited since
+// it was queued. An exhausted budget becomes 1 ms, which still gets the
+// 0-ply ranking.
+gnubg_addon::HintConfig budget_left(const gnubg_addon::HintConfig& config,
+                                    std::chrono::steady_clock::time_point queued) {
+    gnubg_addon::HintConfig left = config;
+
+    if (config.timeBudgetMs > 0) {
+        auto const waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - queued).count();
+        left.timeBudgetMs = static_cast<int>(std::max<long long>(1, config.timeBudgetMs - waited));
+    }
+    return left;
+}
+
+// gnubg_parallel_for on top of the addon's pool
+void pool_parallel_for(unsigned int count, void (*fn)(void* data, unsigned int i), void* data) {
+    gnubg_addon::ThreadPool::instance().parallelFor(count, [fn, data](unsigned i) { fn(data, i); });
+}
+
 } // anonymous namespace
 
 namespace gnubg_addon {
 
 // Static member initialization
+std::mutex HintWrapper::s_configLock;
 bool HintWrapper::s_initialized = false;
-HintConfig HintWrapper::s_config;
+int HintWrapper::s_cacheSizeMB = HintConfig().cacheSizeMB;  // what EvalInitialise allocates
+std::string HintWrapper::s_cacheFile;
+bool HintWrapper::s_quantized = false;
+
+static Napi::Array moves_to_js(Napi::Env env, const std::vector<Move>& moves) {
+    auto moveArray = Napi::Array::New(env, moves.size());
+    for (size_t i = 0; i < moves.size(); i++) {
+        moveArray.Set(uint32_t(i), moves[i].toJsObject(env));
+    }
+    return moveArray;
+}
+
+static Evaluation evaluation_from(const float ar[NUM_ROLLOUT_OUTPUTS]) {
+    return Evaluation {
+        .win = ar[OUTPUT_WIN],
+        .winGammon = ar[OUTPUT_WINGAMMON],
+        .winBackgammon = ar[OUTPUT_WINBACKGAMMON],
+        .loseGammon = ar[OUTPUT_LOSEGAMMON],
+        .loseBackgammon = ar[OUTPUT_LOSEBACKGAMMON],
+        .equity = ar[OUTPUT_EQUITY],
+        .cubefulEquity = ar[OUTPUT_CUBEFUL_EQUITY]
+    };
+}
+
+static Move move_from(const move& m, int rank) {
+    Move hint;
+
+    // Convert anMove array to move steps (use cMoves to avoid stale entries)
+    const int stepCount = std::min<int>(m.cMoves, 4);
+    for (int j = 0; j < stepCount; j++) {
+        const int from = m.anMove[j * 2];
+        const int to = m.anMove[j * 2 + 1];
+        if (from < 0) {
+            break;
+        }
+        hint.steps.push_back({from, to});
+    }
+
+    hint.eval = evaluation_from(m.arEvalMove);
+    hint.equity = m.rScore;
+    hint.rank = rank;
+    hint.plies = m.esMove.ec.nPlies;
+    return hint;
+}
+
+static RolloutResult rollout_from(const gnubg_rollout_result& r, const cubeinfo& ci, bool cubeful) {
+    RolloutResult result;
+    result.mean = evaluation_from(r.mean);
+    result.stdDev = evaluation_from(r.std_dev);
+    if (!cubeful) {
+        result.equity = r.mean[OUTPUT_EQUITY];
+    } else {
+        result.equity = ci.nMatchTo ? mwc2eq(r.mean[OUTPUT_CUBEFUL_EQUITY], &ci) : r.mean[OUTPUT_CUBEFUL_EQUITY];
+    }
+    result.games = static_cast<int>(r.games);
+    result.stopped = r.stopped != 0;
+    return result;
+}
+
+// Passes gnubg's progress reports on to a RolloutProgressFn
+struct RolloutProgressContext {
+    const RolloutProgressFn& progress;
+    const cubeinfo& ci;
+    bool cubeful;
+    const move* moves;  // the alternatives of a move rollout, or null
+};
+
+static void rollout_progress(void* user_data, int alternative, const gnubg_rollout_result* result, float jsd) {
+    auto* context = static_cast<RolloutProgressContext*>(user_data);
+
+    if (context->moves) {
+        const Move hint = move_from(context->moves[alternative], alternative + 1);
+        context->progress(alternative, &hint, rollout_from(*result, context->ci, context->cubeful), jsd);
+    } else {
+        context->progress(alternative, nullptr, rollout_from(*result, context->ci, context->cubeful), jsd);
+    }
+}
 
 // Functional factory implementation for HintConfig
 HintConfig HintConfig::fromJsObject(const Napi::Object& obj) {
+    return fromJsObject(obj, HintConfig());
+}
+
+HintConfig HintConfig::fromJsObject(const Napi::Object& obj, const HintConfig& defaults) {
     return HintConfig {
-        .evalPlies = obj.Has("evalPlies") ? obj.Get("evalPlies").As<Napi::Number>().Int32Value() : 2,
-        .moveFilter = obj.Has("moveFilter") ? obj.Get("moveFilter").As<Napi::Number>().Int32Value() : 2,
-        .threadCount = obj.Has("threadCount") ? obj.Get("threadCount").As<Napi::Number>().Int32Value() : 1,
-        .usePruning = obj.Has("usePruning") ? obj.Get("usePruning").As<Napi::Boolean>().Value() : true,
-        .noise = obj.Has("noise") ? obj.Get("noise").As<Napi::Number>().DoubleValue() : 0.0
+        .evalPlies = obj.Has("evalPlies") ? obj.Get("evalPlies").As<Napi::Number>().Int32Value() : defaults.evalPlies,
+        .moveFilter = obj.Has("moveFilter") ? obj.Get("moveFilter").As<Napi::Number>().Int32Value() : defaults.moveFilter,
+        .threadCount = obj.Has("threadCount") ? obj.Get("threadCount").As<Napi::Number>().Int32Value() : defaults.threadCount,
+        .usePruning = obj.Has("usePruning") ? obj.Get("usePruning").As<Napi::Boolean>().Value() : defaults.usePruning,
+        .noise = obj.Has("noise") ? obj.Get("noise").As<Napi::Number>().DoubleValue() : defaults.noise,
+        .useCache = obj.Has("useCache") ? obj.Get("useCache").As<Napi::Boolean>().Value() : defaults.useCache,
+        .parallelEval = obj.Has("parallelEval") ? obj.Get("parallelEval").As<Napi::Boolean>().Value() : defaults.parallelEval,
+        .cacheSizeMB = obj.Has("cacheSizeMB") ? obj.Get("cacheSizeMB").As<Napi::Number>().Int32Value() : defaults.cacheSizeMB,
+        .cacheFile = obj.Has("cacheFile") && obj.Get("cacheFile").IsString()
+            ? obj.Get("cacheFile").As<Napi::String>().Utf8Value() : defaults.cacheFile,
+        .hintMemoSize = obj.Has("hintMemoSize") ? obj.Get("hintMemoSize").As<Napi::Number>().Int32Value() : defaults.hintMemoSize,
+        .quantized = obj.Has("quantized") ? obj.Get("quantized").As<Napi::Boolean>().Value() : defaults.quantized,
+        .timeBudgetMs = obj.Has("timeBudgetMs") ? obj.Get("timeBudgetMs").As<Napi::Number>().Int32Value() : defaults.timeBudgetMs
+    };
+}
+
+RolloutConfig RolloutConfig::fromJsObject(const Napi::Object& obj) {
+    const RolloutConfig defaults;
+    return RolloutConfig {
+        .trials = obj.Has("trials") ? obj.Get("trials").As<Napi::Number>().Int32Value() : defaults.trials,
+        .truncatePlies = obj.Has("truncatePlies") ? obj.Get("truncatePlies").As<Napi::Number>().Int32Value() : defaults.truncatePlies,
+        .evalPlies = obj.Has("evalPlies") ? obj.Get("evalPlies").As<Napi::Number>().Int32Value() : defaults.evalPlies,
+        .cubeful = obj.Has("cubeful") ? obj.Get("cubeful").As<Napi::Boolean>().Value() : defaults.cubeful,
+        .varianceReduction = obj.Has("varianceReduction") ? obj.Get("varianceReduction").As<Napi::Boolean>().Value() : defaults.varianceReduction,
+        .quasiRandomDice = obj.Has("quasiRandomDice") ? obj.Get("quasiRandomDice").As<Napi::Boolean>().Value() : defaults.quasiRandomDice,
+        .seed = obj.Has("seed") ? obj.Get("seed").As<Napi::Number>().DoubleValue() : defaults.seed,
+        .threads = obj.Has("threads") ? obj.Get("threads").As<Napi::Number>().Int32Value() : defaults.threads,
+        .batchGames = obj.Has("batchGames") ? obj.Get("batchGames").As<Napi::Number>().Int32Value() : defaults.batchGames,
+        .stopOnStd = obj.Has("stopOnStd") ? obj.Get("stopOnStd").As<Napi::Boolean>().Value() : defaults.stopOnStd,
+        .stdLimit = obj.Has("stdLimit") ? obj.Get("stdLimit").As<Napi::Number>().DoubleValue() : defaults.stdLimit,
+        .minGames = obj.Has("minGames") ? obj.Get("minGames").As<Napi::Number>().Int32Value() : defaults.minGames,
+        .stopOnJsd = obj.Has("stopOnJsd") ? obj.Get("stopOnJsd").As<Napi::Boolean>().Value() : defaults.stopOnJsd,
+        .jsdLimit = obj.Has("jsdLimit") ? obj.Get("jsdLimit").As<Napi::Number>().DoubleValue() : defaults.jsdLimit,
+        .minJsdGames = obj.Has("minJsdGames") ? obj.Get("minJsdGames").As<Napi::Number>().Int32Value() : defaults.minJsdGames
     };
 }
 
@@ -246,11 +413,7 @@ Napi::Object Evaluation::toJsObject(Napi::Env env) const {
     return obj;
 }
 
-// Convert Move to JS object
-Napi::Object Move::toJsObject(Napi::Env env) const {
-    auto obj = Napi::Object::New(env);
-
-    // Convert steps array
+Napi::Array Move::stepsToJs(Napi::Env env) const {
     auto stepsArray = Napi::Array::New(env, steps.size());
     for (size_t i = 0; i < steps.size(); i++) {
         auto step = Napi::Array::New(env, 2);
@@ -258,12 +421,35 @@ Napi::Object Move::toJsObject(Napi::Env env) const {
         step.Set(uint32_t(1), Napi::Number::New(env, steps[i][1]));
         stepsArray.Set(uint32_t(i), step);
     }
+    return stepsArray;
+}
+
+// Convert Move to JS object
+Napi::Object Move::toJsObject(Napi::Env env) const {
+    auto obj = Napi::Object::New(env);
 
-    obj.Set("moves", stepsArray);
+    obj.Set("moves", stepsToJs(env));
     obj.Set("evaluation", eval.toJsObject(env));
     obj.Set("equity", Napi::Number::New(env, equity));
     obj.Set("rank", Napi::Number::New(env, rank));
+    obj.Set("plies", Napi::Number::New(env, plies));
+
+    return obj;
+}
 
+Napi::Object RolloutResult::toJsObject(Napi::Env env) const {
+    auto obj = Napi::Object::New(env);
+    obj.Set("evaluation", mean.toJsObject(env));
+    obj.Set("stdDev", stdDev.toJsObject(env));
+    obj.Set("equity", Napi::Number::New(env, equity));
+    obj.Set("games", Napi::Number::New(env, games));
+    obj.Set("stopped", Napi::Boolean::New(env, stopped));
+    return obj;
+}
+
+Napi::Object MoveRollout::toJsObject(Napi::Env env) const {
+    auto obj = move.toJsObject(env);
+    obj.Set("rollout", rollout.toJsObject(env));
     return obj;
 }
 
@@ -305,20 +491,100 @@ bool HintWrapper::initialize(const std::string& weightsPath) {
 }
 
 void HintWrapper::shutdown() {
+    // Requests still queued are dropped and fail; running evaluations are
+    // cancelled, so the pool only waits for each to reach its next check
+    PoolWorker::CancelAll("GnuBgHints shut down");
+
+    std::lock_guard<std::mutex> lock(s_configLock);
+    ThreadPool::instance().shutdown();
     if (s_initialized) {
         // Shutdown GNU Backgammon evaluation engine
         gnubg_shutdown();
         s_initialized = false;
+        // a new initialize() loads the float nets again, and makes a new
+        // cache of the default size
+        s_quantized = false;
+        s_cacheSizeMB = HintConfig().cacheSizeMB;
+        s_cacheFile.clear();
     }
 }
 
-void HintWrapper::configure(const HintConfig& config) {
-    s_config = config;
+// Only sets the engine defaults, thread count, cache and net mode; requests
+// pass their own config, so this is not called per request
+bool HintWrapper::configure(const HintConfig& config) {
+    std::lock_guard<std::mutex> lock(s_configLock);
+    if (!s_initialized) {
+        // shut down meanwhile; initialize() applies its own config
+        return true;
+    }
+
+    // The pool is sized by threadCount, and gnubg_configure() switches the
+    // evals between locking and non-locking versions to match; nothing may
+    // be evaluating while that happens, nor while the cache is reallocated
+    // or the nets are switched
+    ThreadPool& pool = ThreadPool::instance();
+    const unsigned threads = static_cast<unsigned>(std::max(config.threadCount, 1));
+    const bool quiesce = pool.size() != threads || config.cacheSizeMB != s_cacheSizeMB
+        || config.cacheFile != s_cacheFile || config.quantized != s_quantized;
+
+    if (quiesce) {
+        pool.stop();
+    }
     gnubg_configure(config.evalPlies, config.moveFilter, config.usePruning ? 1 : 0,
                     config.noise, config.threadCount);
+    gnubg_set_hint_memo_size(static_cast<unsigned>(std::max(config.hintMemoSize, 0)));
+    const bool netsOk = setQuantized(config.quantized);
+    const bool cacheOk = setupCache(config);
+    if (quiesce) {
+        pool.start(threads);
+    }
+    return netsOk && cacheOk;
 }
 
-std::vector<Move> HintWrapper::getMoveHints(const HintRequest& request, int maxHints) {
+// A cache file that cannot be used leaves the current cache in place; a
+// failed resize falls back to the engine's default size
+bool HintWrapper::setupCache(const HintConfig& config) {
+    if (config.cacheSizeMB == s_cacheSizeMB && config.cacheFile == s_cacheFile) {
+        return true;
+    }
+
+    const unsigned sizeMB = static_cast<unsigned>(std::max(config.cacheSizeMB, 1));
+    if (!config.cacheFile.empty()) {
+        if (gnubg_open_cache_file(config.cacheFile.c_str(), sizeMB) != 0) {
+            return false;
+        }
+    } else if (gnubg_set_cache_size(sizeMB) != 0) {
+        s_cacheSizeMB = HintConfig().cacheSizeMB;
+        s_cacheFile.clear();
+        return false;
+    }
+
+    s_cacheSizeMB = config.cacheSizeMB;
+    s_cacheFile = config.cacheFile;
+    return true;
+}
+
+// Switching the nets empties the caches and leaves a cache file behind,
+// since its entries came from the other nets; setupCache() then opens the
+// file again, which takes it only if it was written in the new mode
+bool HintWrapper::setQuantized(bool quantized) {
+    if (quantized == s_quantized) {
+        return true;
+    }
+    if (gnubg_set_quantized(quantized ? 1 : 0) != 0) {
+        return false;
+    }
+
+    s_quantized = quantized;
+    if (!s_cacheFile.empty()) {
+        s_cacheSizeMB = 0;
+        s_cacheFile.clear();
+    }
+    return true;
+}
+
+std::vector<Move> HintWrapper::getMoveHints(const HintRequest& request, int maxHints, const HintConfig& config,
+                                            const int* cancel) {
     std::vector<Move> results;
 
     if (!s_initialized) {
@@ -356,37 +622,13 @@ std::vector<Move> HintWrapper::getMoveHints(const HintRequest& request, int maxH
     ml.amMoves = new move[maxHints];
 
     // Call real GNU Backgammon hint function
-    int result = gnubg_hint_move_with_cube(board, dice, ml.amMoves, maxHints, &ci);
+    const gnubg_eval_settings settings = to_eval_settings(config, cancel);
+    int result = gnubg_hint_move_with_settings(board, dice, ml.amMoves, maxHints, &ci, &settings);
     ml.cMoves = (result > 0) ? result : 0;
     if (result > 0) {
         // Convert GNU BG moves to our Move structure
         for (unsigned int i = 0; i < ml.cMoves && i < (unsigned int)maxHints; i++) {
-            Move hint;
-
-            // Convert anMove array to move steps (use cMoves to avoid stale entries)
-            const int stepCount = std::min<int>(ml.amMoves[i].cMoves, 4);
-            for (int j = 0; j < stepCount; j++) {
-                const int from = ml.amMoves[i].anMove[j * 2];
-                const int to = ml.amMoves[i].anMove[j * 2 + 1];
-                if (from < 0) {
-                    break;
-                }
-                std::array<int, 2> step = {from, to};
-                hint.steps.push_back(step);
-            }
-
-            // Set evaluation data
-            hint.eval.win = ml.amMoves[i].arEvalMove[OUTPUT_WIN];
-            hint.eval.winGammon = ml.amMoves[i].arEvalMove[OUTPUT_WINGAMMON];
-            hint.eval.winBackgammon = ml.amMoves[i].arEvalMove[OUTPUT_WINBACKGAMMON];
-            hint.eval.loseGammon = ml.amMoves[i].arEvalMove[OUTPUT_LOSEGAMMON];
-            hint.eval.loseBackgammon = ml.amMoves[i].arEvalMove[OUTPUT_LOSEBACKGAMMON];
-            hint.eval.equity = ml.amMoves[i].arEvalMove[OUTPUT_EQUITY];
-            hint.eval.cubefulEquity = ml.amMoves[i].arEvalMove[OUTPUT_CUBEFUL_EQUITY];
-            hint.equity = ml.amMoves[i].rScore;
-            hint.rank = i + 1;
-
-            results.push_back(hint);
+            results.push_back(move_from(ml.amMoves[i], i + 1));
         }
     }
 
@@ -394,7 +636,97 @@ std::vector<Move> HintWrapper::getMoveHints(const HintRequest& request, int maxH
     return results;
 }
 
-DoubleHint HintWrapper::getDoubleHint(const HintRequest& request) {
+RolloutResult HintWrapper::rolloutPosition(const HintRequest& request, const RolloutConfig& config,
+                                           const int* cancel, const RolloutProgressFn& progress) {
+    if (!s_initialized) {
+        throw std::runtime_error("GnuBgHints not initialized");
+    }
+
+    TanBoard board;
+    cubeinfo ci;
+
+    if (request.hasBoard) {
+        for (int player = 0; player < 2; player++) {
+            for (int point = 0; point < 25; point++) {
+                board[player][point] = request.board[player][point];
+            }
+        }
+    } else if (request.positionId.empty()) {
+        throw std::runtime_error("Invalid board data");
+    } else if (!decode_position_id(request.positionId, board)) {
+        throw std::runtime_error("Invalid position ID");
+    }
+
+    int scores[2] = {request.matchScore[0], request.matchScore[1]};
+    SetCubeInfo(&ci, request.cubeValue, request.cubeOwner, 1, request.matchLength, scores,
+                request.crawford ? 1 : 0, request.jacoby ? 1 : 0,
+                request.beavers ? 1 : 0, bgvDefault);
+
+    const gnubg_rollout_settings settings = to_rollout_settings(config, cancel);
+    RolloutProgressContext context{progress, ci, config.cubeful, nullptr};
+    gnubg_rollout_result result;
+
+    if (gnubg_rollout_position(board, &ci, &settings, &result, progress ? rollout_progress : nullptr,
+                               &context) != 0) {
+        throw std::runtime_error("Rollout failed");
+    }
+    return rollout_from(result, ci, config.cubeful);
+}
+
+std::vector<MoveRollout> HintWrapper::rolloutMoves(const HintRequest& request, int maxMoves,
+                                                   const RolloutConfig& config, const int* cancel,
+                                                   const RolloutProgressFn& progress) {
+    if (!s_initialized) {
+        throw std::runtime_error("GnuBgHints not initialized");
+    }
+
+    TanBoard board;
+    int dice[2] = {request.dice[0], request.dice[1]};
+    cubeinfo ci;
+
+    if (request.hasBoard) {
+        for (int player = 0; player < 2; player++) {
+            for (int point = 0; point < 25; point++) {
+                board[player][point] = request.board[player][point];
+            }
+        }
+    } else if (request.positionId.empty()) {
+        throw std::runtime_error("Invalid board data");
+    } else if (!decode_position_id(request.positionId, board)) {
+        throw std::runtime_error("Invalid position ID");
+    }
+
+    int scores[2] = {request.matchScore[0], request.matchScore[1]};
+    SetCubeInfo(&ci, request.cubeValue, request.cubeOwner, 1, request.matchLength, scores,
+                request.crawford ? 1 : 0, request.jacoby ? 1 : 0,
+                request.beavers ? 1 : 0, bgvDefault);
+
+    const gnubg_rollout_settings settings = to_rollout_settings(config, cancel);
+    std::vector<move> moves(static_cast<size_t>(std::max(maxMoves, 1)));
+    std::vector<gnubg_rollout_result> results(moves.size());
+    RolloutProgressContext context{progress, ci, config.cubeful, moves.data()};
+
+    const int count = gnubg_rollout_moves(board, dice, &ci, &settings, moves.data(), results.data(),
+                                          static_cast<int>(moves.size()), progress ? rollout_progress : nullptr,
+                                          &context);
+    if (count < 0) {
+        throw std::runtime_error("Rollout failed");
+    }
+
+    std::vector<MoveRollout> rollouts;
+    for (int i = 0; i < count; i++) {
+        rollouts.push_back({move_from(moves[i], 0), rollout_from(results[i], ci, config.cubeful)});
+    }
+    std::stable_sort(rollouts.begin(), rollouts.end(), [](const MoveRollout& a, const MoveRollout& b) {
+        return a.move.equity > b.move.equity;
+    });
+    for (size_t i = 0; i < rollouts.size(); i++) {
+        rollouts[i].move.rank = static_cast<int>(i) + 1;
+    }
+    return rollouts;
+}
+
+DoubleHint HintWrapper::getDoubleHint(const HintRequest& request, const HintConfig& config, const int* cancel) {
     DoubleHint result;
     result.action = "no-double";
     result.takePoint = 0.0;
@@ -437,7 +769,8 @@ DoubleHint HintWrapper::getDoubleHint(const HintRequest& request) {
 
     // Get double hint from GNU Backgammon
     float equity = 0.0f;
-    int gnubgResult = gnubg_hint_double(board, &ci, &equity);
+    const gnubg_eval_settings settings = to_eval_settings(config, cancel);
+    int gnubgResult = gnubg_hint_double_with_settings(board, &ci, &equity, &settings);
 
     if (gnubgResult >= 0) {
         auto determineAction = [](int decision) -> std::string {
@@ -481,7 +814,7 @@ DoubleHint HintWrapper::getDoubleHint(const HintRequest& request) {
     return result;
 }
 
-TakeHint HintWrapper::getTakeHint(const HintRequest& request) {
+TakeHint HintWrapper::getTakeHint(const HintRequest& request, const HintConfig& config, const int* cancel) {
     TakeHint result;
     result.action = "drop";
     result.eval.win = 0.0;
@@ -523,7 +856,8 @@ TakeHint HintWrapper::getTakeHint(const HintRequest& request) {
 
     // Get take hint from GNU Backgammon
     float equities[2] = {0.0f, -1.0f};
-    int gnubgResult = gnubg_hint_take(board, &ci, equities);
+    const gnubg_eval_settings settings = to_eval_settings(config, cancel);
+    int gnubgResult = gnubg_hint_take_with_settings(board, &ci, equities, &settings);
 
     if (gnubgResult >= 0) {
         auto determineAction = [](int decision, double take, double drop) -> std::string {
@@ -558,20 +892,42 @@ TakeHint HintWrapper::getTakeHint(const HintRequest& request) {
 }
 
 // Async worker implementations
-InitializeWorker::InitializeWorker(Napi::Function& callback, const std::string& weightsPath)
-    : Napi::AsyncWorker(callback), m_weightsPath(weightsPath), m_success(false) {}
+InitializeWorker::InitializeWorker(Napi::Function& callback, const std::string& weightsPath,
+                                   const HintConfig& config)
+    : Napi::AsyncWorker(callback), m_weightsPath(weightsPath), m_config(config), m_success(false) {}
 
 void InitializeWorker::Execute() {
     m_success = HintWrapper::initialize(m_weightsPath);
     if (!m_success) {
         SetError("Failed to initialize GNU Backgammon engine");
+        return;
+    }
+
+    // Quantise the nets and allocate a large cache here rather than on the
+    // JS thread in OnOK()
+    if (!HintWrapper::setQuantized(m_config.quantized)) {
+        m_success = false;
+        SetError("Failed to quantise the neural nets");
+        return;
+    }
+    m_success = HintWrapper::setupCache(m_config);
+    if (!m_success) {
+        SetError(m_config.cacheFile.empty()
+            ? "Failed to allocate the evaluation cache"
+            : "Failed to open cache file " + m_config.cacheFile);
+        return;
     }
+
+    // Starts the pool; the nets and cache are set up already
+    HintWrapper::configure(m_config);
+    gnubg_set_parallel_for(pool_parallel_for);
 }
 
 void InitializeWorker::OnOK() {
     // Set global state to indicate successful initialization
     gnubg_addon::g_state.initialized = true;
     gnubg_addon::g_state.weightsPath = m_weightsPath;
+    gnubg_addon::g_state.config = m_config;
 
     Callback().Call({Env().Null()});
 }
@@ -580,9 +936,29 @@ void InitializeWorker::OnError(const Napi::Error& error) {
     Callback().Call({error.Value()});
 }
 
+ConfigureWorker::ConfigureWorker(Napi::Function& callback, const HintConfig& config)
+    : Napi::AsyncWorker(callback), m_config(config) {}
+
+void ConfigureWorker::Execute() {
+    if (!HintWrapper::configure(m_config)) {
+        SetError(m_config.cacheFile.empty()
+            ? "Failed to allocate the evaluation cache"
+            : "Failed to open cache file " + m_config.cacheFile);
+    }
+}
+
+void ConfigureWorker::OnOK() {
+    Callback().Call({Env().Null()});
+}
+
+void ConfigureWorker::OnError(const Napi::Error& error) {
+    Callback().Call({error.Value()});
+}
+
 MoveHintWorker::MoveHintWorker(Napi::Function& callback, const HintRequest& request,
                                int maxHints, const HintConfig& config)
-    : Napi::AsyncWorker(callback), m_request(request), m_maxHints(maxHints), m_config(config) {}
+    : PoolWorker(callback), m_request(request), m_maxHints(maxHints), m_config(config),
+      m_queued(std::chrono::steady_clock::now()) {}
 
 void MoveHintWorker::Execute() {
     try {
@@ -591,8 +967,7 @@ void MoveHintWorker::Execute() {
             return;
         }
 
-        HintWrapper::configure(m_config);
-        m_results = HintWrapper::getMoveHints(m_request, m_maxHints);
+        m_results = HintWrapper::getMoveHints(m_request, m_maxHints, budget_left(m_config, m_queued), CancelFlag());
     } catch (const std::exception& ex) {
         SetError(ex.what());
     }
@@ -613,9 +988,288 @@ void MoveHintWorker::OnError(const Napi::Error& error) {
     Callback().Call({error.Value()});
 }
 
+std::mutex PoolWorker::s_liveLock;
+std::unordered_set<PoolWorker*> PoolWorker::s_live;
+
+PoolWorker::PoolWorker(Napi::Function& callback)
+    : m_env(callback.Env()), m_callback(Napi::Persistent(callback)),
+      m_tsfn(Napi::ThreadSafeFunction::New(callback.Env(), callback, "gnubg_hints", 0, 1)) {
+    std::lock_guard<std::mutex> lock(s_liveLock);
+    s_live.insert(this);
+}
+
+void PoolWorker::Queue() {
+    ThreadPool::instance().submit([this]() {
+        Run();
+        Complete();
+    }, [this]() {
+        SetError("GnuBgHints shut down");
+        Complete();
+    });
+}
+
+void PoolWorker::Run() {
+    if (!Cancelled()) {
+        Execute();
+    }
+    // An evaluation cut short fails or comes back incomplete; either way
+    // the request only learns that it was cancelled
+    if (Cancelled()) {
+        SetError("Cancelled");
+    }
+}
+
+void PoolWorker::CancelAll(const std::string& error) {
+    std::lock_guard<std::mutex> lock(s_liveLock);
+    for (PoolWorker* worker : s_live) {
+        // The error goes first, so that it wins over "Cancelled"
+        worker->SetError(error);
+        worker->m_cancel->store(1);
+    }
+}
+
+Napi::Function PoolWorker::CancelFunction() {
+    std::shared_ptr<std::atomic<int>> cancel = m_cancel;
+    return Napi::Function::New(m_env, [cancel](const Napi::CallbackInfo&) {
+        cancel->store(1);
+    });
+}
+
+const int* PoolWorker::CancelFlag() const {
+    // Read in C with an atomic load of an int
+    static_assert(sizeof(std::atomic<int>) == sizeof(int) && std::atomic<int>::is_always_lock_free,
+                  "std::atomic<int> must be a plain int");
+    return reinterpret_cast<const int*>(m_cancel.get());
+}
+
+void PoolWorker::SetError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(m_errorLock);
+    if (m_error.empty()) {
+        m_error = error;
+    }
+}
+
+void PoolWorker::Post(std::function<void(Napi::Env)> fn) {
+    m_tsfn.BlockingCall([fn](Napi::Env env, Napi::Function) {
+        fn(env);
+    });
+}
+
+void PoolWorker::Complete() {
+    {
+        std::lock_guard<std::mutex> lock(s_liveLock);
+        s_live.erase(this);
+    }
+
+    // The JS thread may delete this before Release() returns. Dropped
+    // workers complete on the JS thread itself; the queue is unbounded, so
+    // BlockingCall() does not block there.
+    Napi::ThreadSafeFunction tsfn = m_tsfn;
+    tsfn.BlockingCall([this](Napi::Env env, Napi::Function) {
+        if (m_error.empty()) {
+            OnOK();
+        } else {
+            OnError(Napi::Error::New(env, m_error));
+        }
+        delete this;
+    });
+    tsfn.Release();
+}
+
+BatchMoveHintWorker::BatchMoveHintWorker(Napi::Function& callback, Napi::Function& progress,
+                                         std::vector<HintRequest> requests, std::vector<HintConfig> configs,
+                                         int maxHints)
+    : PoolWorker(callback),
+      m_requests(std::move(requests)), m_configs(std::move(configs)),
+      m_maxHints(maxHints), m_queued(std::chrono::steady_clock::now()), m_results(m_requests.size()),
+      m_remaining(m_requests.size()) {
+    if (!progress.IsEmpty()) {
+        m_progress = Napi::Persistent(progress);
+    }
+}
+
+void BatchMoveHintWorker::Queue() {
+    if (m_requests.empty()) {
+        Complete();
+        return;
+    }
+
+    // One task per position, so idle workers can steal them individually
+    for (size_t i = 0; i < m_requests.size(); i++) {
+        ThreadPool::instance().submit([this, i]() { evaluate(i); }, [this]() {
+            SetError("GnuBgHints shut down");
+            if (--m_remaining == 0) {
+                Complete();
+            }
+        });
+    }
+}
+
+void BatchMoveHintWorker::evaluate(size_t index) {
+    if (!m_failed && !Cancelled()) {
+        try {
+            m_results[index] = HintWrapper::getMoveHints(m_requests[index], m_maxHints,
+                                                         budget_left(m_configs[index], m_queued), CancelFlag());
+            if (!m_progress.IsEmpty() && !Cancelled()) {
+                Post([this, index](Napi::Env env) {
+                    m_progress.Call({Napi::Number::New(env, double(index)), moves_to_js(env, m_results[index])});
+                });
+            }
+        } catch (const std::exception& ex) {
+            m_failed = true;
+            SetError("Position " + std::to_string(index) + ": " + ex.what());
+        }
+    }
+
+    // The positions still queued are skipped, not evaluated
+    if (Cancelled()) {
+        SetError("Cancelled");
+    }
+
+    // Progress posted by every task is queued ahead of the completion
+    if (--m_remaining == 0) {
+        Complete();
+    }
+}
+
+void BatchMoveHintWorker::OnOK() {
+    auto env = Env();
+    auto resultArray = Napi::Array::New(env, m_results.size());
+
+    for (size_t i = 0; i < m_results.size(); i++) {
+        resultArray.Set(uint32_t(i), moves_to_js(env, m_results[i]));
+    }
+
+    Callback().Call({env.Null(), resultArray});
+}
+
+void BatchMoveHintWorker::OnError(const Napi::Error& error) {
+    Callback().Call({error.Value()});
+}
+
+RolloutWorker::RolloutWorker(Napi::Function& callback, Napi::Function& progress, const HintRequest& request,
+                             int maxMoves, const RolloutConfig& config)
+    : PoolWorker(callback), m_request(request), m_maxMoves(maxMoves), m_config(config) {
+    if (!progress.IsEmpty()) {
+        m_progress = Napi::Persistent(progress);
+    }
+}
+
+std::mutex RolloutWorker::s_queueLock;
+std::deque<RolloutWorker*> RolloutWorker::s_waiting;
+bool RolloutWorker::s_running = false;
+
+// gnubg runs one rollout at a time. Rather than have the next one hold a
+// pool thread while it waits, it only goes to the pool once the one before
+// it is done.
+void RolloutWorker::Queue() {
+    {
+        std::lock_guard<std::mutex> lock(s_queueLock);
+        if (s_running) {
+            s_waiting.push_back(this);
+            return;
+        }
+        s_running = true;
+    }
+    submit();
+}
+
+void RolloutWorker::submit() {
+    ThreadPool::instance().submit([this]() {
+        Run();
+        RolloutWorker* following = next();
+        Complete();
+        if (following) {
+            // parked if the pool is stopping, and dropped if it shuts down
+            following->submit();
+        }
+    }, [this]() {
+        // The pool shut down before this one ran; the ones behind it will
+        // not run either
+        std::deque<RolloutWorker*> waiting;
+        {
+            std::lock_guard<std::mutex> lock(s_queueLock);
+            waiting.swap(s_waiting);
+            s_running = false;
+        }
+        for (RolloutWorker* worker : waiting) {
+            worker->SetError("GnuBgHints shut down");
+            worker->Complete();
+        }
+        SetError("GnuBgHints shut down");
+        Complete();
+    });
+}
+
+// The rollout to run after the one just done, or none
+RolloutWorker* RolloutWorker::next() {
+    std::lock_guard<std::mutex> lock(s_queueLock);
+    if (s_waiting.empty()) {
+        s_running = false;
+        return nullptr;
+    }
+    RolloutWorker* following = s_waiting.front();
+    s_waiting.pop_front();
+    return following;
+}
+
+void RolloutWorker::Execute() {
+    RolloutProgressFn progress;
+    if (!m_progress.IsEmpty()) {
+        progress = [this](int alternative, const Move* move, const RolloutResult& result, double jsd) {
+            if (Cancelled()) {
+                return;
+            }
+            // the move's own evaluation is still the 0-ply one here
+            std::optional<Move> played = move ? std::optional<Move>(*move) : std::nullopt;
+            Post([this, alternative, played, result, jsd](Napi::Env env) {
+                auto event = Napi::Object::New(env);
+                event.Set("alternative", Napi::Number::New(env, alternative));
+                if (played) {
+                    event.Set("moves", played->stepsToJs(env));
+                }
+                event.Set("rollout", result.toJsObject(env));
+                event.Set("jsd", Napi::Number::New(env, jsd));
+                m_progress.Call({event});
+            });
+        };
+    }
+
+    try {
+        if (m_maxMoves > 0) {
+            m_moves = HintWrapper::rolloutMoves(m_request, m_maxMoves, m_config, CancelFlag(), progress);
+        } else {
+            m_position = HintWrapper::rolloutPosition(m_request, m_config, CancelFlag(), progress);
+        }
+    } catch (const std::exception& ex) {
+        // a cancelled rollout fails, but Queue() reports it as cancelled
+        if (!Cancelled()) {
+            SetError(ex.what());
+        }
+    }
+}
+
+void RolloutWorker::OnOK() {
+    auto env = Env();
+
+    if (m_maxMoves > 0) {
+        auto resultArray = Napi::Array::New(env, m_moves.size());
+        for (size_t i = 0; i < m_moves.size(); i++) {
+            resultArray.Set(uint32_t(i), m_moves[i].toJsObject(env));
+        }
+        Callback().Call({env.Null(), resultArray});
+    } else {
+        Callback().Call({env.Null(), m_position.toJsObject(env)});
+    }
+}
+
+void RolloutWorker::OnError(const Napi::Error& error) {
+    Callback().Call({error.Value()});
+}
+
 DoubleHintWorker::DoubleHintWorker(Napi::Function& callback, const HintRequest& request,
                                    const HintConfig& config)
-    : Napi::AsyncWorker(callback), m_request(request), m_config(config) {}
+    : PoolWorker(callback), m_request(request), m_config(config) {}
 
 void DoubleHintWorker::Execute() {
     try {
@@ -624,8 +1278,7 @@ void DoubleHintWorker::Execute() {
             return;
         }
 
-        HintWrapper::configure(m_config);
-        m_result = HintWrapper::getDoubleHint(m_request);
+        m_result = HintWrapper::getDoubleHint(m_request, m_config, CancelFlag());
     } catch (const std::exception& ex) {
         SetError(ex.what());
     }
@@ -641,7 +1294,7 @@ void DoubleHintWorker::OnError(const Napi::Error& error) {
 
 TakeHintWorker::TakeHintWorker(Napi::Function& callback, const HintRequest& request,
                                const HintConfig& config)
-    : Napi::AsyncWorker(callback), m_request(request), m_config(config) {}
+    : PoolWorker(callback), m_request(request), m_config(config) {}
 
 void TakeHintWorker::Execute() {
     try {
@@ -650,8 +1303,7 @@ void TakeHintWorker::Execute() {
             return;
         }
 
-        HintWrapper::configure(m_config);
-        m_result = HintWrapper::getTakeHint(m_request);
+        m_result = HintWrapper::getTakeHint(m_request, m_config, CancelFlag());
     } catch (const std::exception& ex) {
         SetError(ex.what());
     }
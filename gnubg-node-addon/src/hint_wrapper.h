@@ -5,6 +5,13 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
 
 namespace gnubg_addon {
 
@@ -15,9 +22,39 @@ struct HintConfig {
     int threadCount = 1;
     bool usePruning = true;
     double noise = 0.0;
+    bool useCache = true;
+    bool parallelEval = false;
+    int cacheSizeMB = 32;       // process-wide, like threadCount
+    std::string cacheFile;      // process-wide; empty keeps the cache in memory
+    int hintMemoSize = 1024;    // process-wide; move hints remembered, 0 = off
+    bool quantized = false;     // process-wide; int16 hidden layer weights
+    int timeBudgetMs = 0;       // move hints: deepest ranking done in this time, 0 = no limit
 
-    // Functional factory method from JS object
+    // Functional factory methods from JS object; fields missing from obj
+    // keep their value in defaults
     static HintConfig fromJsObject(const Napi::Object& obj);
+    static HintConfig fromJsObject(const Napi::Object& obj, const HintConfig& defaults);
+};
+
+// Rollout settings; unlike HintConfig these are given per call only
+struct RolloutConfig {
+    int trials = 1296;
+    int truncatePlies = 0;          // 0 plays every game out
+    int evalPlies = 0;              // lookahead for the plays and cube decisions in the games
+    bool cubeful = true;
+    bool varianceReduction = true;
+    bool quasiRandomDice = true;
+    double seed = 0;
+    int threads = 0;                // engine threads, up to threadCount; 0 = all
+    int batchGames = 0;             // games per thread in lock-step, up to 64; 0 = one at a time
+    bool stopOnStd = false;
+    double stdLimit = 0.01;
+    int minGames = 324;
+    bool stopOnJsd = false;
+    double jsdLimit = 2.33;
+    int minJsdGames = 324;
+
+    static RolloutConfig fromJsObject(const Napi::Object& obj);
 };
 
 // Request structure for hints
@@ -57,10 +94,37 @@ struct Move {
     Evaluation eval;
     double equity;
     int rank;
+    int plies;  // ply the move was scored at; below evalPlies if filtered out or out of time
 
     Napi::Object toJsObject(Napi::Env env) const;
+    Napi::Array stepsToJs(Napi::Env env) const;
 };
 
+// Rollout of a position or move so far; in a match the cubeful figures
+// are match winning chances, and equity is always in money terms
+struct RolloutResult {
+    Evaluation mean;
+    Evaluation stdDev;
+    double equity;
+    int games;
+    bool stopped;  // by stopOnStd or stopOnJsd
+
+    Napi::Object toJsObject(Napi::Env env) const;
+};
+
+struct MoveRollout {
+    Move move;  // its eval and equity are the rollout's
+    RolloutResult rollout;
+
+    Napi::Object toJsObject(Napi::Env env) const;
+};
+
+// Called as a rollout goes, on the thread running it, for each alternative
+// (0 for a position; a move's index in the 0-ply ranking, with the move).
+// jsd is how many joint standard deviations the move is behind the best.
+using RolloutProgressFn = std::function<void(int alternative, const Move* move, const RolloutResult& result,
+                                             double jsd)>;
+
 // Double hint result
 struct DoubleHint {
     std::string action;  // "double", "no-double", "too-good", "beaver", "redouble"
@@ -86,32 +150,124 @@ struct TakeHint {
 class HintWrapper {
 public:
     static bool initialize(const std::string& weightsPath);
+    // Fails the requests still running or queued, waits for each running
+    // evaluation to reach its next check, and frees the engine
     static void shutdown();
-    static void configure(const HintConfig& config);
+    // False if the evaluation cache or the net mode could not be set up as
+    // asked. A new thread count, cache or net mode waits for the running
+    // evaluations to finish, so this is not for the JS thread.
+    static bool configure(const HintConfig& config);
+    static bool setupCache(const HintConfig& config);
+    static bool setQuantized(bool quantized);
+
+    // Each request carries its own config; nothing here is shared between
+    // requests, so they can run concurrently with different settings. The
+    // evaluation gives up soon after *cancel becomes nonzero.
+    static std::vector<Move> getMoveHints(const HintRequest& request, int maxHints, const HintConfig& config,
+                                          const int* cancel = nullptr);
+    static DoubleHint getDoubleHint(const HintRequest& request, const HintConfig& config,
+                                    const int* cancel = nullptr);
+    static TakeHint getTakeHint(const HintRequest& request, const HintConfig& config,
+                                const int* cancel = nullptr);
 
-    static std::vector<Move> getMoveHints(const HintRequest& request, int maxHints);
-    static DoubleHint getDoubleHint(const HintRequest& request);
-    static TakeHint getTakeHint(const HintRequest& request);
+    // Rollouts run one at a time on up to threadCount engine threads,
+    // started for each rollout; RolloutWorker queues them, so none waits
+    // for another in a pool thread. The moves come back best first.
+    static RolloutResult rolloutPosition(const HintRequest& request, const RolloutConfig& config,
+                                         const int* cancel, const RolloutProgressFn& progress);
+    static std::vector<MoveRollout> rolloutMoves(const HintRequest& request, int maxMoves,
+                                                 const RolloutConfig& config, const int* cancel,
+                                                 const RolloutProgressFn& progress);
 
 private:
+    static std::mutex s_configLock;  // configure() against shutdown()
     static bool s_initialized;
-    static HintConfig s_config;
+    static int s_cacheSizeMB;
+    static std::string s_cacheFile;
+    static bool s_quantized;
 };
 
 // Async worker classes for non-blocking operations
 class InitializeWorker : public Napi::AsyncWorker {
 public:
-    InitializeWorker(Napi::Function& callback, const std::string& weightsPath);
+    InitializeWorker(Napi::Function& callback, const std::string& weightsPath, const HintConfig& config);
     void Execute() override;
     void OnOK() override;
     void OnError(const Napi::Error& error) override;
 
 private:
     std::string m_weightsPath;
+    HintConfig m_config;
     bool m_success;
 };
 
-class MoveHintWorker : public Napi::AsyncWorker {
+// Applies a configuration's thread count, cache and net mode
+class ConfigureWorker : public Napi::AsyncWorker {
+public:
+    ConfigureWorker(Napi::Function& callback, const HintConfig& config);
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error& error) override;
+
+private:
+    HintConfig m_config;
+};
+
+// Counterpart of Napi::AsyncWorker for evaluation jobs: Execute() runs on
+// the addon's ThreadPool, and OnOK()/OnError() come back on the JS thread
+// through a thread-safe function. The worker deletes itself afterwards.
+class PoolWorker {
+public:
+    explicit PoolWorker(Napi::Function& callback);
+    virtual ~PoolWorker() = default;
+
+    virtual void Queue();
+
+    // A JS function that cancels the request: one not started yet is
+    // skipped, and a running evaluation gives up at its next check. Either
+    // way the callback gets a "Cancelled" error. Safe to call at any time,
+    // even after the worker is gone.
+    Napi::Function CancelFunction();
+
+    // Fail every worker not completed yet with error, and cancel it
+    static void CancelAll(const std::string& error);
+
+protected:
+    virtual void Execute() {}
+    // Execute() unless cancelled, on a pool thread; a cancelled request
+    // fails with "Cancelled"
+    void Run();
+    virtual void OnOK() = 0;
+    virtual void OnError(const Napi::Error& error) = 0;
+
+    // Safe to call from any pool thread; the first error wins
+    void SetError(const std::string& error);
+    // Run fn on the JS thread, in order with other posts and completion
+    void Post(std::function<void(Napi::Env)> fn);
+    // Report OnOK()/OnError() on the JS thread and release the worker
+    void Complete();
+
+    bool Cancelled() const { return m_cancel->load() != 0; }
+    // The flag for gnubg_eval_settings.cancel
+    const int* CancelFlag() const;
+
+    Napi::Env Env() const { return m_env; }
+    Napi::FunctionReference& Callback() { return m_callback; }
+
+private:
+    Napi::Env m_env;
+    Napi::FunctionReference m_callback;
+    Napi::ThreadSafeFunction m_tsfn;
+    std::mutex m_errorLock;
+    std::string m_error;
+    // Shared with the cancel function, which may outlive the worker
+    std::shared_ptr<std::atomic<int>> m_cancel = std::make_shared<std::atomic<int>>(0);
+
+    static std::mutex s_liveLock;
+    static std::unordered_set<PoolWorker*> s_live;  // not completed yet
+};
+
+class MoveHintWorker : public PoolWorker {
 public:
     MoveHintWorker(Napi::Function& callback, const HintRequest& request,
                    int maxHints, const HintConfig& config);
@@ -123,10 +279,64 @@ private:
     HintRequest m_request;
     int m_maxHints;
     HintConfig m_config;
+    std::chrono::steady_clock::time_point m_queued;  // a time budget counts from here
     std::vector<Move> m_results;
 };
 
-class DoubleHintWorker : public Napi::AsyncWorker {
+// Move hints for many positions in one call. Each position is its own
+// pool task, and each one is reported through the progress callback as
+// soon as its hints are ready.
+class BatchMoveHintWorker : public PoolWorker {
+public:
+    BatchMoveHintWorker(Napi::Function& callback, Napi::Function& progress,
+                        std::vector<HintRequest> requests, std::vector<HintConfig> configs,
+                        int maxHints);
+    void Queue() override;
+    void OnOK() override;
+    void OnError(const Napi::Error& error) override;
+
+private:
+    void evaluate(size_t index);
+
+    std::vector<HintRequest> m_requests;
+    std::vector<HintConfig> m_configs;
+    int m_maxHints;
+    std::chrono::steady_clock::time_point m_queued;
+    Napi::FunctionReference m_progress;
+    std::vector<std::vector<Move>> m_results;
+    std::atomic<size_t> m_remaining;
+    std::atomic<bool> m_failed{false};
+};
+
+// A rollout of the position (maxMoves 0) or of its best maxMoves moves,
+// with each progress report passed on to the progress callback
+class RolloutWorker : public PoolWorker {
+public:
+    RolloutWorker(Napi::Function& callback, Napi::Function& progress, const HintRequest& request,
+                  int maxMoves, const RolloutConfig& config);
+    // Submitted once the rollouts queued before it are done
+    void Queue() override;
+    void Execute() override;
+    void OnOK() override;
+    void OnError(const Napi::Error& error) override;
+
+private:
+    void submit();
+    static RolloutWorker* next();
+
+    static std::mutex s_queueLock;
+    static std::deque<RolloutWorker*> s_waiting;  // behind the running one
+    static bool s_running;
+
+    HintRequest m_request;
+    int m_maxMoves;
+    RolloutConfig m_config;
+    Napi::FunctionReference m_progress;
+    RolloutResult m_position;
+    std::vector<MoveRollout> m_moves;
+};
+
+class DoubleHintWorker : public PoolWorker {
 public:
     DoubleHintWorker(Napi::Function& callback, const HintRequest& request,
                      const HintConfig& config);
@@ -140,7 +350,7 @@ private:
     DoubleHint m_result;
 };
 
-class TakeHintWorker : public Napi::AsyncWorker {
+class TakeHintWorker : public PoolWorker {
 public:
     TakeHintWorker(Napi::Function& callback, const HintRequest& request,
                    const HintConfig& config);
@@ -112,6 +112,11 @@ export interface HintRequest {
   crawford: boolean
   jacoby: boolean
   beavers: boolean
+  /**
+   * Evaluation settings for this request only. Fields left out fall back to
+   * the values set with GnuBgHints.configure().
+   */
+  config?: Partial<HintConfig>
 }
 
 /**
@@ -136,6 +141,7 @@ export interface MoveHint {
   equity: number
   rank: number
   difference: number // Equity difference from best move
+  plies: number // Ply the move was scored at (below evalPlies if filtered out or out of time)
 }
 
 export interface MoveStep {
@@ -189,6 +195,76 @@ export interface HintConfig {
   threadCount?: number // Number of threads for evaluation
   usePruning?: boolean // Use pruning neural networks
   noise?: number // Evaluation noise (0.0 = deterministic)
+  useCache?: boolean // Look up and store evaluations in the shared cache
+  parallelEval?: boolean // Spread one 1+ ply hint's candidates and rolls over threadCount threads
+  cacheSizeMB?: number // Size of the shared evaluation cache, for the whole process
+  cacheFile?: string // Keep the evaluation cache in this file, shared between processes
+  hintMemoSize?: number // Move hints remembered whole, for the whole process (0 = off)
+  quantized?: boolean // Evaluate with 16-bit hidden layer weights, for the whole process
+  timeBudgetMs?: number // Move hints: return the deepest ranking finished in this time (0 = no limit)
+}
+
+/**
+ * Rollout settings. The games are played at evalPlies with the pruning
+ * nets; everything else about the engine comes from configure()
+ */
+export interface RolloutConfig {
+  trials?: number // Games per position or move (default 1296)
+  truncatePlies?: number // Evaluate the game after this many plies (0 = play it out)
+  evalPlies?: number // Lookahead for the plays and cube decisions in the games (default 0)
+  cubeful?: boolean // Play the cube in the games (default true)
+  varianceReduction?: boolean // Subtract each roll's luck (default true)
+  quasiRandomDice?: boolean // Spread the first rolls evenly over the games (default true)
+  seed?: number // Same seed and settings, same results (default 0)
+  threads?: number // Engine threads to use, up to threadCount (0 = all)
+  batchGames?: number // Games each thread plays in lock-step, up to 64, batching their evaluations (0 = one at a time)
+  stopOnStd?: boolean // Stop once the equity's standard error is below stdLimit ...
+  stdLimit?: number
+  minGames?: number // ... after at least this many games
+  stopOnJsd?: boolean // Moves: stop a move once it is jsdLimit joint standard deviations behind the best ...
+  jsdLimit?: number
+  minJsdGames?: number // ... after at least this many games
+}
+
+/**
+ * Rollout of a position or a move. In a match, the cubeful figures are
+ * match winning chances; equity is always in money terms
+ */
+export interface RolloutResult {
+  evaluation: Evaluation // Mean over the games
+  stdDev: Evaluation // Standard error of each mean
+  equity: number
+  games: number
+  stopped: boolean // Stopped early by stopOnStd or stopOnJsd
+}
+
+export interface MoveRollout {
+  moves: MoveStep[]
+  equity: number
+  rank: number
+  difference: number // Equity difference from best move
+  rollout: RolloutResult
+}
+
+/**
+ * Rollout so far of one alternative: the position (alternative 0), or a
+ * move, numbered by its place in the 0-ply ranking
+ */
+export interface RolloutProgress {
+  alternative: number
+  moves?: MoveStep[]
+  rollout: RolloutResult
+  jsd: number // Joint standard deviations behind the best move
+}
+
+/**
+ * Counters of the move hint memo
+ */
+export interface HintMemoStats {
+  hits: number
+  misses: number
+  entries: number
+  capacity: number
 }
 
 type PointCounts = { white: number; black: number }
@@ -215,18 +291,28 @@ export class GnuBgHints {
     threadCount: 1,
     usePruning: true,
     noise: 0.0,
+    useCache: true,
+    parallelEval: false,
+    cacheSizeMB: 32,
+    hintMemoSize: 1024,
+    quantized: false,
+    timeBudgetMs: 0,
   }
 
   /**
-   * Initialize the hint engine with neural network weights
+   * Initialize the hint engine with neural network weights. Settings that
+   * allocate (threadCount, cacheSizeMB) can be given here, so that they
+   * are set up once instead of again on the first configure()
    */
-  static async initialize(weightsPath?: string): Promise<void> {
+  static async initialize(weightsPath?: string, config?: Partial<HintConfig>): Promise<void> {
     if (this.initialized) {
       return
     }
 
+    this.config = { ...this.config, ...config }
+
     return new Promise((resolve, reject) => {
-      addon.initialize(weightsPath || DEFAULT_WEIGHTS_PATH, (err: Error | null) => {
+      addon.initialize(weightsPath || DEFAULT_WEIGHTS_PATH, this.config, (err: Error | null) => {
         if (err) {
           reject(err)
         } else {
@@ -238,11 +324,21 @@ export class GnuBgHints {
   }
 
   /**
-   * Configure the hint engine
+   * Configure the hint engine. The evaluation settings apply to requests
+   * made from now on. A new threadCount, cacheSizeMB, cacheFile or
+   * quantized is expensive: it waits for the running hints to finish, off
+   * the JS thread, and requests made meanwhile wait for it. The promise
+   * settles once it is in place.
    */
-  static configure(config: Partial<HintConfig>): void {
+  static configure(config: Partial<HintConfig>): Promise<void> {
     this.config = { ...this.config, ...config }
-    addon.configure(this.config)
+
+    let done: (err: Error | null) => void = () => {}
+    const applied = new Promise<void>((resolve, reject) => {
+      done = (err) => (err ? reject(err) : resolve())
+    })
+    addon.configure(this.config, done)
+    return applied
   }
 
   /**
@@ -314,11 +410,13 @@ export class GnuBgHints {
   }
 
   /**
-   * Get move hints for a given position and dice roll
+   * Get move hints for a given position and dice roll. Aborting `signal`
+   * rejects with its reason at once and stops the native search.
    */
   static async getMoveHints(
     request: HintRequest,
-    maxHints: number = 10
+    maxHints: number = 10,
+    signal?: AbortSignal
   ): Promise<MoveHint[]> {
     if (!this.initialized) {
       throw new Error('GnuBgHints not initialized. Call initialize() first.')
@@ -336,32 +434,15 @@ export class GnuBgHints {
       )
     }
 
-    return new Promise((resolve, reject) => {
-      // Convert board to GNU Backgammon format using active player's perspective
-      const { gnubgBoard, normalization } = this.convertBoardToGnuBg(
-        request.board,
+    return this.cancellable<MoveHint[]>(signal, (resolve, reject) => {
+      const { gnubgRequest, normalization } = this.convertMoveRequestToGnuBg(
+        request,
         activePlayerColor,
         activePlayerDirection
       )
 
-      addon.getMoveHints(
-        {
-          board: gnubgBoard,
-          dice: request.dice,
-          cubeValue: request.cubeValue,
-          cubeOwner: this.normalizeCubeOwner(
-            request.cubeOwner,
-            activePlayerColor
-          ),
-          matchScore: this.normalizeMatchScore(
-            request.matchScore,
-            activePlayerColor
-          ),
-          matchLength: request.matchLength,
-          crawford: request.crawford,
-          jacoby: request.jacoby,
-          beavers: request.beavers,
-        },
+      return addon.getMoveHints(
+        gnubgRequest,
         maxHints,
         (err: Error | null, hints: any[]) => {
           if (err) {
@@ -377,9 +458,88 @@ export class GnuBgHints {
   }
 
   /**
-   * Get doubling decision hint
+   * Get move hints for many positions in one native call. The positions are
+   * shared out between `threadCount` native threads; `onProgress` is called
+   * with each position's index and hints as soon as they are ready, in
+   * completion order. The promise resolves with all hints in request order.
+   * Aborting `signal` rejects at once and skips the positions not done yet.
    */
-  static async getDoubleHint(request: HintRequest): Promise<DoubleHint> {
+  static async getMoveHintsBatch(
+    requests: HintRequest[],
+    maxHints: number = 10,
+    onProgress?: (index: number, hints: MoveHint[]) => void,
+    signal?: AbortSignal
+  ): Promise<MoveHint[][]> {
+    if (!this.initialized) {
+      throw new Error('GnuBgHints not initialized. Call initialize() first.')
+    }
+
+    if (!Array.isArray(requests)) {
+      return Promise.reject(new Error('Expected an array of requests'))
+    }
+
+    const converted: Array<{
+      gnubgRequest: object
+      normalization: GnubgNormalization
+    }> = []
+    for (let i = 0; i < requests.length; i++) {
+      const request = requests[i]
+      if (!request?.board || typeof request.board !== 'object') {
+        return Promise.reject(new Error(`Invalid board data at index ${i}`))
+      }
+      if (!request.activePlayerDirection) {
+        return Promise.reject(
+          new Error(
+            `activePlayerDirection is required for GNU normalization (index ${i})`
+          )
+        )
+      }
+      converted.push(
+        this.convertMoveRequestToGnuBg(
+          request,
+          request.activePlayerColor ?? 'white',
+          request.activePlayerDirection
+        )
+      )
+    }
+
+    const toHints = (index: number, hints: any[]): MoveHint[] =>
+      this.convertHintsFromGnuBg(
+        hints,
+        requests[index].board,
+        converted[index].normalization
+      )
+
+    return this.cancellable<MoveHint[][]>(signal, (resolve, reject) =>
+      addon.getMoveHintsBatch(
+        converted.map((c) => c.gnubgRequest),
+        maxHints,
+        (err: Error | null, results: any[][]) => {
+          if (err) {
+            reject(err)
+          } else {
+            resolve(results.map((hints, index) => toHints(index, hints)))
+          }
+        },
+        onProgress
+          ? (index: number, hints: any[]) => {
+              if (!signal?.aborted) {
+                onProgress(index, toHints(index, hints))
+              }
+            }
+          : undefined
+      )
+    )
+  }
+
+  /**
+   * Get doubling decision hint. Aborting `signal` rejects with its reason
+   * at once and stops the native evaluation.
+   */
+  static async getDoubleHint(
+    request: HintRequest,
+    signal?: AbortSignal
+  ): Promise<DoubleHint> {
     if (!this.initialized) {
       throw new Error('GnuBgHints not initialized. Call initialize() first.')
     }
@@ -396,14 +556,14 @@ export class GnuBgHints {
       )
     }
 
-    return new Promise((resolve, reject) => {
+    return this.cancellable<DoubleHint>(signal, (resolve, reject) => {
       const { gnubgBoard } = this.convertBoardToGnuBg(
         request.board,
         activePlayerColor,
         activePlayerDirection
       )
 
-      addon.getDoubleHint(
+      return addon.getDoubleHint(
         {
           board: gnubgBoard,
           cubeValue: request.cubeValue,
@@ -419,6 +579,7 @@ export class GnuBgHints {
           crawford: request.crawford,
           jacoby: request.jacoby,
           beavers: request.beavers,
+          config: request.config,
         },
         (err: Error | null, hint: any) => {
           if (err) {
@@ -432,9 +593,13 @@ export class GnuBgHints {
   }
 
   /**
-   * Get take/drop decision hint
+   * Get take/drop decision hint. Aborting `signal` rejects with its reason
+   * at once and stops the native evaluation.
    */
-  static async getTakeHint(request: HintRequest): Promise<TakeHint> {
+  static async getTakeHint(
+    request: HintRequest,
+    signal?: AbortSignal
+  ): Promise<TakeHint> {
     if (!this.initialized) {
       throw new Error('GnuBgHints not initialized. Call initialize() first.')
     }
@@ -451,14 +616,14 @@ export class GnuBgHints {
       )
     }
 
-    return new Promise((resolve, reject) => {
+    return this.cancellable<TakeHint>(signal, (resolve, reject) => {
       const { gnubgBoard } = this.convertBoardToGnuBg(
         request.board,
         activePlayerColor,
         activePlayerDirection
       )
 
-      addon.getTakeHint(
+      return addon.getTakeHint(
         {
           board: gnubgBoard,
           cubeValue: request.cubeValue,
@@ -474,6 +639,7 @@ export class GnuBgHints {
           crawford: request.crawford,
           jacoby: request.jacoby,
           beavers: request.beavers,
+          config: request.config,
         },
         (err: Error | null, hint: any) => {
           if (err) {
@@ -487,7 +653,155 @@ export class GnuBgHints {
   }
 
   /**
-   * Shutdown the hint engine and free resources
+   * Roll out a position, with the player in `request` on roll and about to
+   * roll. `onProgress` gets the results so far every two seconds or so.
+   * Rollouts run one at a time on the `threadCount` engine threads.
+   * Aborting `signal` rejects at once and stops the games.
+   */
+  static async rolloutPosition(
+    request: Omit<HintRequest, 'dice'>,
+    config: RolloutConfig = {},
+    onProgress?: (progress: RolloutProgress) => void,
+    signal?: AbortSignal
+  ): Promise<RolloutResult> {
+    if (!this.initialized) {
+      throw new Error('GnuBgHints not initialized. Call initialize() first.')
+    }
+
+    if (!request?.board || typeof request.board !== 'object') {
+      return Promise.reject(new Error('Invalid board data'))
+    }
+
+    if (!request.activePlayerDirection) {
+      return Promise.reject(
+        new Error('activePlayerDirection is required for GNU normalization')
+      )
+    }
+
+    const { gnubgRequest } = this.convertMoveRequestToGnuBg(
+      request,
+      request.activePlayerColor ?? 'white',
+      request.activePlayerDirection
+    )
+
+    return this.cancellable<RolloutResult>(signal, (resolve, reject) =>
+      addon.rolloutPosition(
+        gnubgRequest,
+        config,
+        (err: Error | null, result: any) => {
+          if (err) {
+            reject(err)
+          } else {
+            resolve(this.convertRolloutFromGnuBg(result))
+          }
+        },
+        onProgress
+          ? (progress: any) => {
+              if (!signal?.aborted) {
+                onProgress({
+                  alternative: progress.alternative,
+                  rollout: this.convertRolloutFromGnuBg(progress.rollout),
+                  jsd: progress.jsd,
+                })
+              }
+            }
+          : undefined
+      )
+    )
+  }
+
+  /**
+   * Roll out the best `maxMoves` moves for the roll, as ranked at 0-ply,
+   * and rank them by the rollout. With `stopOnJsd`, moves that fall
+   * clearly behind stop early. Progress and cancelling work as in
+   * rolloutPosition().
+   */
+  static async rolloutMoves(
+    request: HintRequest,
+    maxMoves: number = 5,
+    config: RolloutConfig = {},
+    onProgress?: (progress: RolloutProgress) => void,
+    signal?: AbortSignal
+  ): Promise<MoveRollout[]> {
+    if (!this.initialized) {
+      throw new Error('GnuBgHints not initialized. Call initialize() first.')
+    }
+
+    if (!request?.board || typeof request.board !== 'object') {
+      return Promise.reject(new Error('Invalid board data'))
+    }
+
+    if (!request.activePlayerDirection) {
+      return Promise.reject(
+        new Error('activePlayerDirection is required for GNU normalization')
+      )
+    }
+
+    const { gnubgRequest, normalization } = this.convertMoveRequestToGnuBg(
+      request,
+      request.activePlayerColor ?? 'white',
+      request.activePlayerDirection
+    )
+
+    return this.cancellable<MoveRollout[]>(signal, (resolve, reject) =>
+      addon.rolloutMoves(
+        gnubgRequest,
+        maxMoves,
+        config,
+        (err: Error | null, results: any[]) => {
+          if (err) {
+            reject(err)
+            return
+          }
+          const baseEquity = results.length > 0 ? results[0].equity : 0
+          resolve(
+            results.map((result, index) => ({
+              moves: this.convertMovesFromGnuBg(
+                result.moves,
+                request.board,
+                normalization
+              ),
+              equity: result.equity,
+              rank: index + 1,
+              difference: result.equity - baseEquity,
+              rollout: this.convertRolloutFromGnuBg(result.rollout),
+            }))
+          )
+        },
+        onProgress
+          ? (progress: any) => {
+              if (!signal?.aborted) {
+                onProgress({
+                  alternative: progress.alternative,
+                  moves: this.convertMovesFromGnuBg(
+                    progress.moves,
+                    request.board,
+                    normalization
+                  ),
+                  rollout: this.convertRolloutFromGnuBg(progress.rollout),
+                  jsd: progress.jsd,
+                })
+              }
+            }
+          : undefined
+      )
+    )
+  }
+
+  /**
+   * Hit and miss counts of the move hint memo since the process started.
+   * Requests with noise or useCache: false bypass the memo and count as
+   * neither.
+   */
+  static getHintMemoStats(): HintMemoStats {
+    return addon.getHintMemoStats()
+  }
+
+  /**
+   * Shutdown the hint engine and free resources. Requests still running or
+   * queued reject with "GnuBgHints shut down"; this waits for each running
+   * evaluation to stop at its next check, then frees the nets, databases
+   * and caches, so it is not free either.
    */
   static shutdown(): void {
     if (this.initialized) {
@@ -681,6 +995,41 @@ export class GnuBgHints {
     return { points, bar, off }
   }
 
+  /**
+   * Build the addon's move hint request from a HintRequest, from the point
+   * of view of the player on roll
+   */
+  private static convertMoveRequestToGnuBg(
+    request: Omit<HintRequest, 'dice'> & Partial<Pick<HintRequest, 'dice'>>,
+    activePlayerColor: BackgammonColor,
+    activePlayerDirection: BackgammonMoveDirection
+  ): { gnubgRequest: object; normalization: GnubgNormalization } {
+    const { gnubgBoard, normalization } = this.convertBoardToGnuBg(
+      request.board,
+      activePlayerColor,
+      activePlayerDirection
+    )
+
+    return {
+      gnubgRequest: {
+        board: gnubgBoard,
+        dice: request.dice,
+        cubeValue: request.cubeValue,
+        cubeOwner: this.normalizeCubeOwner(request.cubeOwner, activePlayerColor),
+        matchScore: this.normalizeMatchScore(
+          request.matchScore,
+          activePlayerColor
+        ),
+        matchLength: request.matchLength,
+        crawford: request.crawford,
+        jacoby: request.jacoby,
+        beavers: request.beavers,
+        config: request.config,
+      },
+      normalization,
+    }
+  }
+
   /**
    * Convert BackgammonBoard to GNU Backgammon format (2D array)
    * GNU BG uses: [2][25] array where [1] is player on roll, [0] is opponent
@@ -773,6 +1122,42 @@ export class GnuBgHints {
     }
   }
 
+  /**
+   * A promise for a native call that returns its cancel function. The
+   * promise rejects with the signal's reason as soon as it aborts, and the
+   * native request is cancelled so it stops taking CPU; its own callback
+   * then has nothing left to settle.
+   */
+  private static cancellable<T>(
+    signal: AbortSignal | undefined,
+    start: (
+      resolve: (value: T) => void,
+      reject: (reason: unknown) => void
+    ) => (() => void) | undefined
+  ): Promise<T> {
+    return new Promise<T>((resolve, reject) => {
+      if (signal?.aborted) {
+        reject(signal.reason)
+        return
+      }
+
+      let cancel: (() => void) | undefined
+      const onAbort = () => {
+        cancel?.()
+        reject(signal?.reason)
+      }
+      const done =
+        <A>(settle: (value: A) => void) =>
+        (value: A) => {
+          signal?.removeEventListener('abort', onAbort)
+          settle(value)
+        }
+
+      cancel = start(done(resolve), done(reject))
+      signal?.addEventListener('abort', onAbort, { once: true })
+    })
+  }
+
   private static normalizeMatchScore(
     matchScore: [number, number],
     activePlayerColor: BackgammonColor
@@ -817,6 +1202,7 @@ export class GnuBgHints {
       equity: hint?.equity ?? 0,
       rank: index + 1,
       difference: index === 0 ? 0 : (hint?.equity ?? 0) - baseEquity,
+      plies: hint?.plies ?? 0,
     }))
   }
 
@@ -1012,6 +1398,19 @@ export class GnuBgHints {
     }
   }
 
+  /**
+   * Convert a GNU Backgammon rollout result
+   */
+  private static convertRolloutFromGnuBg(gnubgRollout: any): RolloutResult {
+    return {
+      evaluation: this.normalizeEvaluation(gnubgRollout?.evaluation),
+      stdDev: this.normalizeEvaluation(gnubgRollout?.stdDev),
+      equity: gnubgRollout?.equity ?? 0,
+      games: gnubgRollout?.games ?? 0,
+      stopped: gnubgRollout?.stopped ?? false,
+    }
+  }
+
   /**
    * Convert GNU Backgammon double hint
    */
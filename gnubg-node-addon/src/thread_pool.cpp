@@ -0,0 +1,279 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+extern "C" {
+    #include "../include/gnubg_core.h"
+}
+
+namespace gnubg_addon {
+
+namespace {
+
+// Index of the calling pool worker, -1 on any other thread
+thread_local int t_workerIndex = -1;
+
+#if defined(__linux__)
+// CPU sets of the online NUMA nodes, read from sysfs. Empty when there is
+// only one node or the information is unavailable.
+std::vector<cpu_set_t> numa_node_cpus() {
+    std::vector<cpu_set_t> nodes;
+
+    for (int node = 0; ; node++) {
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!file)
+            break;
+
+        // Format is a comma-separated list of CPUs and ranges: "0-7,16-23"
+        std::string list;
+        std::getline(file, list);
+        std::stringstream ranges(list);
+        std::string range;
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+
+        while (std::getline(ranges, range, ',')) {
+            const size_t dash = range.find('-');
+            const int first = std::stoi(range.substr(0, dash));
+            const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+                CPU_SET(cpu, &cpus);
+        }
+
+        if (CPU_COUNT(&cpus) > 0)
+            nodes.push_back(cpus);
+    }
+
+    if (nodes.size() < 2)
+        nodes.clear();
+    return nodes;
+}
+#endif
+
+// Bind the calling worker to one NUMA node, so that the evaluation state it
+// allocates next is local to the CPUs it runs on
+void bind_to_numa_node(unsigned index) {
+#if defined(__linux__)
+    static const std::vector<cpu_set_t> nodes = numa_node_cpus();
+    if (nodes.empty())
+        return;
+
+    const cpu_set_t& cpus = nodes[index % nodes.size()];
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpus);
+#else
+    (void)index;
+#endif
+}
+
+// Shared between the threads taking part in one parallelFor(); helper
+// tasks that start after every index is claimed just find nothing to do
+struct ParallelJob {
+    std::function<void(unsigned)> fn;
+    unsigned count;
+    std::atomic<unsigned> next{0};
+    std::atomic<unsigned> done{0};
+    std::mutex lock;
+    std::condition_variable finished;
+
+    void work() {
+        for (unsigned i = next++; i < count; i = next++) {
+            fn(i);
+            if (++done == count) {
+                std::lock_guard<std::mutex> guard(lock);
+                finished.notify_all();
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+void ThreadPool::start(unsigned threadCount) {
+    threadCount = std::max(threadCount, 1u);
+    std::lock_guard<std::mutex> control(m_controlLock);
+    if (m_size == threadCount)
+        return;
+
+    stopWorkers();
+
+    std::lock_guard<std::mutex> state(m_stateLock);
+    for (unsigned i = 0; i < threadCount; i++)
+        m_workers.push_back(std::make_unique<Worker>());
+
+    // Hand out whatever was queued while stopped before any thread runs
+    for (Job& job : m_parked)
+        m_workers[m_nextWorker++ % threadCount]->tasks.push_back(std::move(job));
+    m_pending = m_parked.size();
+    m_parked.clear();
+
+    for (unsigned i = 0; i < threadCount; i++)
+        m_workers[i]->thread = std::thread(&ThreadPool::run, this, i);
+    m_size = threadCount;
+    m_accepting = true;
+}
+
+void ThreadPool::stop() {
+    std::lock_guard<std::mutex> control(m_controlLock);
+    stopWorkers();
+}
+
+void ThreadPool::shutdown() {
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> control(m_controlLock);
+        stopWorkers();
+        std::lock_guard<std::mutex> state(m_stateLock);
+        dropped.swap(m_parked);
+    }
+
+    for (Job& job : dropped)
+        if (job.drop)
+            job.drop();
+}
+
+// With m_controlLock held. The workers stay in m_workers until joined,
+// since they steal from each other through it; submit() parks from the
+// moment they are told to stop.
+void ThreadPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> state(m_stateLock);
+        if (m_workers.empty())
+            return;
+        m_accepting = false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepLock);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& worker : m_workers)
+        worker->thread.join();
+
+    // Tasks that were queued go ahead of those parked while joining
+    std::lock_guard<std::mutex> state(m_stateLock);
+    std::deque<Job> queued;
+    for (auto& worker : m_workers)
+        for (Job& job : worker->tasks)
+            queued.push_back(std::move(job));
+    for (Job& job : m_parked)
+        queued.push_back(std::move(job));
+    m_parked.swap(queued);
+
+    m_workers.clear();
+    m_size = 0;
+    m_pending = 0;
+    m_stopping = false;
+}
+
+void ThreadPool::submit(Task task, Task drop) {
+    {
+        std::lock_guard<std::mutex> state(m_stateLock);
+        if (!m_accepting) {
+            m_parked.push_back(Job{std::move(task), std::move(drop)});
+            return;
+        }
+
+        // Work submitted from a worker stays with it; the rest is dealt out
+        const unsigned index = t_workerIndex >= 0
+            ? static_cast<unsigned>(t_workerIndex)
+            : m_nextWorker++ % m_workers.size();
+        Worker& worker = *m_workers[index];
+
+        // Same lock order as takeTask(), so the count never runs behind
+        std::lock_guard<std::mutex> lock(worker.lock);
+        worker.tasks.push_back(Job{std::move(task), std::move(drop)});
+        std::lock_guard<std::mutex> sleepLock(m_sleepLock);
+        m_pending++;
+    }
+    m_wake.notify_one();
+}
+
+unsigned ThreadPool::size() const {
+    return m_size;
+}
+
+void ThreadPool::parallelFor(unsigned count, const std::function<void(unsigned)>& fn) {
+    if (count == 0)
+        return;
+
+    auto job = std::make_shared<ParallelJob>();
+    job->fn = fn;
+    job->count = count;
+
+    // One index is always ours, so at most count - 1 helpers are useful
+    const unsigned helpers = std::min(size() > 0 ? size() - 1 : 0, count - 1);
+    for (unsigned i = 0; i < helpers; i++)
+        submit([job]() { job->work(); });
+
+    job->work();
+
+    // Whatever is left is running on other threads right now
+    std::unique_lock<std::mutex> guard(job->lock);
+    job->finished.wait(guard, [&job]() { return job->done == job->count; });
+}
+
+bool ThreadPool::takeTask(unsigned index, Job& job) {
+    const size_t count = m_workers.size();
+
+    for (size_t offset = 0; offset < count && !m_stopping; offset++) {
+        Worker& worker = *m_workers[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(worker.lock);
+        if (worker.tasks.empty())
+            continue;
+
+        // Own work oldest first; stolen work from the other end
+        if (offset == 0) {
+            job = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        } else {
+            job = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+
+        std::lock_guard<std::mutex> sleepLock(m_sleepLock);
+        m_pending--;
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::run(unsigned index) {
+    t_workerIndex = static_cast<int>(index);
+    bind_to_numa_node(index);
+    gnubg_thread_init();
+
+    Job job;
+    while (!m_stopping) {
+        if (takeTask(index, job)) {
+            job.task();
+            job = Job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepLock);
+        m_wake.wait(lock, [this]() { return m_stopping || m_pending > 0; });
+    }
+
+    gnubg_release_thread();
+    t_workerIndex = -1;
+}
+
+} // namespace gnubg_addon
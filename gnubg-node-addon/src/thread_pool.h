@@ -0,0 +1,82 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gnubg_addon {
+
+// Addon-owned worker threads for evaluations, so hint jobs neither compete
+// with fs/dns/crypto for the libuv pool nor stop at its four threads.
+//
+// Each worker has its own deque: it takes work from the front of its own
+// and steals from the back of the others' when that runs dry. On machines
+// with more than one NUMA node, workers are spread round-robin over the
+// nodes and bound to their CPUs before allocating any per-thread state.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    static ThreadPool& instance();
+
+    // Start threadCount workers; a no-op if already running with that many
+    void start(unsigned threadCount);
+    // Wait for the running tasks and join the workers. Tasks still queued,
+    // and those submitted until the next start(), are kept and handed out
+    // by it. Any thread may call this, but not a pool worker.
+    void stop();
+    // Stop for good: the tasks still queued are given up, and the drop
+    // function each was submitted with is called instead, on this thread
+    void shutdown();
+    // drop, if any, stands in for task if the pool shuts down first
+    void submit(Task task, Task drop = nullptr);
+    unsigned size() const;
+
+    // Run fn(i) for every i below count and return when all are done. The
+    // calling thread takes indices as well, so this may be called from a
+    // pool task without the risk of every worker waiting on the others.
+    void parallelFor(unsigned count, const std::function<void(unsigned)>& fn);
+
+    ~ThreadPool();
+
+private:
+    struct Job {
+        Task task;
+        Task drop;
+    };
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<Job> tasks;
+        std::thread thread;
+    };
+
+    ThreadPool() = default;
+    void stopWorkers();
+    void run(unsigned index);
+    bool takeTask(unsigned index, Job& job);
+
+    // start() and stop() may come from different threads (configure()
+    // runs off the JS thread), while submit() comes from anywhere
+    std::mutex m_controlLock;           // one start()/stop() at a time
+    std::mutex m_stateLock;             // m_accepting, m_parked and m_workers being replaced
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::deque<Job> m_parked;           // queued while stopped
+    bool m_accepting = false;
+    std::atomic<unsigned> m_size{0};
+    std::mutex m_sleepLock;
+    std::condition_variable m_wake;
+    size_t m_pending = 0;               // guarded by m_sleepLock
+    std::atomic<bool> m_stopping{false};
+    std::atomic<unsigned> m_nextWorker{0};
+};
+
+} // namespace gnubg_addon
+
+#endif // THREAD_POOL_H
@@ -139,6 +139,196 @@ describe('GNU Backgammon Hints Tests', () => {
         expect(hints[i].rank).toBe(i + 1);
       }
     });
+
+    it('should match single requests when batched', async () => {
+      const rolls: Array<[number, number]> = [[3, 1], [6, 4], [5, 5], [2, 1]];
+      const requests: HintRequest[] = rolls.map((dice) => ({
+        board: createStartingBoard(),
+        dice,
+        activePlayerColor: 'white',
+        activePlayerDirection: 'clockwise',
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0],
+        matchLength: 7,
+        crawford: false,
+        jacoby: false,
+        beavers: false,
+        // Past the hint memo (and the cache), or the single requests would
+        // be answered with what the batch just stored
+        config: { useCache: false }
+      }));
+
+      const streamed: number[] = [];
+      const batch = await GnuBgHints.getMoveHintsBatch(requests, 3, (index) => {
+        streamed.push(index);
+      });
+
+      expect(batch).toHaveLength(requests.length);
+      expect(streamed.sort()).toEqual([0, 1, 2, 3]);
+      for (let i = 0; i < requests.length; i++) {
+        const single = await GnuBgHints.getMoveHints(requests[i], 3);
+        expect(batch[i].map((hint) => hint.moves)).toEqual(single.map((hint) => hint.moves));
+      }
+    });
+
+    it('should answer a repeated request from the memo', async () => {
+      const request: HintRequest = {
+        board: createStartingBoard(),
+        dice: [4, 2],
+        activePlayerColor: 'white',
+        activePlayerDirection: 'clockwise',
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0],
+        matchLength: 7,
+        crawford: false,
+        jacoby: false,
+        beavers: false
+      };
+
+      const first = await GnuBgHints.getMoveHints(request, 5);
+      const before = GnuBgHints.getHintMemoStats();
+      const second = await GnuBgHints.getMoveHints(request, 5);
+      const after = GnuBgHints.getHintMemoStats();
+
+      expect(second).toEqual(first);
+      expect(after.hits).toBe(before.hits + 1);
+      expect(after.misses).toBe(before.misses);
+    });
+
+    it('should return a shallower ranking when out of time', async () => {
+      const request: HintRequest = {
+        board: createStartingBoard(),
+        dice: [6, 2],
+        activePlayerColor: 'white',
+        activePlayerDirection: 'clockwise',
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0],
+        matchLength: 7,
+        crawford: false,
+        jacoby: false,
+        beavers: false,
+        // A 3-ply search takes far longer than 1 ms; without the cache the
+        // 0-ply ranking is all that can be finished in time
+        config: { evalPlies: 3, timeBudgetMs: 1, useCache: false }
+      };
+
+      const hints = await GnuBgHints.getMoveHints(request, 5);
+
+      expect(hints.length).toBeGreaterThan(0);
+      expect(hints[0].plies).toBeLessThan(3);
+      for (let i = 0; i < hints.length; i++) {
+        expect(hints[i].rank).toBe(i + 1);
+      }
+    });
+
+    it('should reject a deep request when aborted', async () => {
+      const request: HintRequest = {
+        board: createStartingBoard(),
+        dice: [5, 3],
+        activePlayerColor: 'white',
+        activePlayerDirection: 'clockwise',
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0],
+        matchLength: 7,
+        crawford: false,
+        jacoby: false,
+        beavers: false,
+        config: { evalPlies: 3, useCache: false }
+      };
+      const controller = new AbortController();
+
+      const pending = GnuBgHints.getMoveHints(request, 5, controller.signal);
+      controller.abort(new Error('Cancelled'));
+      await expect(pending).rejects.toThrow('Cancelled');
+
+      // The search was stopped, so the pool is free for the next request
+      const hints = await GnuBgHints.getMoveHints({ ...request, config: { evalPlies: 0 } }, 5);
+      expect(hints.length).toBeGreaterThan(0);
+    });
+  });
+
+  describe('Rollouts', () => {
+    it('should roll out the best moves and report progress', async () => {
+      const request: HintRequest = {
+        board: createStartingBoard(),
+        dice: [4, 3],
+        activePlayerColor: 'white',
+        activePlayerDirection: 'clockwise',
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0],
+        matchLength: 0,
+        crawford: false,
+        jacoby: false,
+        beavers: false
+      };
+
+      const progress: number[] = [];
+      const rollouts = await GnuBgHints.rolloutMoves(request, 3, { trials: 36, truncatePlies: 5, seed: 1 }, (p) => {
+        progress.push(p.alternative);
+      });
+
+      expect(rollouts.length).toBeGreaterThan(0);
+      expect(rollouts.length).toBeLessThanOrEqual(3);
+      for (let i = 0; i < rollouts.length; i++) {
+        expect(rollouts[i].rank).toBe(i + 1);
+        expect(rollouts[i].rollout.games).toBe(36);
+        if (i > 0) {
+          expect(rollouts[i].equity).toBeLessThanOrEqual(rollouts[i - 1].equity);
+        }
+      }
+      expect(new Set(progress).size).toBe(rollouts.length);
+    });
+
+    it('should give the same rollout for the same seed', async () => {
+      const request = {
+        board: createStartingBoard(),
+        activePlayerColor: 'white' as const,
+        activePlayerDirection: 'clockwise' as const,
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0] as [number, number],
+        matchLength: 0,
+        crawford: false,
+        jacoby: false,
+        beavers: false
+      };
+      const config = { trials: 36, truncatePlies: 5, seed: 7 };
+
+      const first = await GnuBgHints.rolloutPosition(request, config);
+      const second = await GnuBgHints.rolloutPosition(request, config);
+
+      expect(first.games).toBe(36);
+      expect(second.evaluation).toEqual(first.evaluation);
+    });
+
+    it('should play the same games in lock-step batches', async () => {
+      const request = {
+        board: createStartingBoard(),
+        activePlayerColor: 'white' as const,
+        activePlayerDirection: 'clockwise' as const,
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0] as [number, number],
+        matchLength: 0,
+        crawford: false,
+        jacoby: false,
+        beavers: false
+      };
+      // One thread, so the games are added up in the same order
+      const config = { trials: 36, truncatePlies: 5, seed: 7, threads: 1 };
+
+      const single = await GnuBgHints.rolloutPosition(request, config);
+      const batched = await GnuBgHints.rolloutPosition(request, { ...config, batchGames: 8 });
+
+      expect(batched.games).toBe(36);
+      expect(batched.evaluation).toEqual(single.evaluation);
+      expect(batched.equity).toEqual(single.equity);
+    });
   });
 
   describe('Double Hints', () => {
@@ -241,6 +431,58 @@ describe('GNU Backgammon Hints Tests', () => {
       await TestClass.initialize();
     });
 
+    it('should reject running and queued requests on shutdown', async () => {
+      const request: HintRequest = {
+        board: createStartingBoard(),
+        dice: [5, 2],
+        activePlayerColor: 'white',
+        activePlayerDirection: 'clockwise',
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0],
+        matchLength: 7,
+        crawford: false,
+        jacoby: false,
+        beavers: false,
+        config: { evalPlies: 3, useCache: false }
+      };
+
+      const pending = [1, 2, 3].map(() => GnuBgHints.getMoveHints(request, 5));
+      GnuBgHints.shutdown();
+
+      for (const hints of pending) {
+        await expect(hints).rejects.toThrow('shut down');
+      }
+
+      await GnuBgHints.initialize();
+    });
+
+    it('should give the same hints after shutdown and initialize again', async () => {
+      const request: HintRequest = {
+        board: createStartingBoard(),
+        dice: [4, 2],
+        activePlayerColor: 'white',
+        activePlayerDirection: 'clockwise',
+        cubeValue: 1,
+        cubeOwner: null,
+        matchScore: [0, 0],
+        matchLength: 7,
+        crawford: false,
+        jacoby: false,
+        beavers: false,
+        config: { evalPlies: 0 }
+      };
+
+      const before = await GnuBgHints.getMoveHints(request, 5);
+
+      GnuBgHints.shutdown();
+      await GnuBgHints.initialize();
+
+      const after = await GnuBgHints.getMoveHints(request, 5);
+      expect(after.map((hint) => hint.moves)).toEqual(before.map((hint) => hint.moves));
+      expect(after[0].equity).toBeCloseTo(before[0].equity, 6);
+    });
+
     it('should handle invalid position IDs gracefully', async () => {
       const invalidPositionId = 'INVALID_ID';
       const dice: [number, number] = [3, 1];